@@ -0,0 +1,358 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* AES using the x86 AES instructions, after Intel's "Advanced Encryption
+   Standard (AES) New Instructions Set" white paper (Gueron, 2010). In a
+   file of its own so that the instructions can be enabled for it alone;
+   raes.c only calls it after checking the CPU, and uses the table code in
+   aes.c otherwise. The modes without a serial dependency (ECB, CTR and CBC
+   decryption) work on AES_NI_LANES blocks at a time, which keeps the
+   pipelined aesenc/aesdec units busy. */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "aes_ni.h"
+
+#if DIGEST_X86_SIMD
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("aes,ssse3"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("aes,ssse3")
+#endif
+
+#define AES_NI_LANES 8
+
+/* the next four words of the schedule, from the previous four and the
+   broadcast output of aeskeygenassist */
+static __m128i _expand(__m128i key, __m128i word) {
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    return _mm_xor_si128(key, word);
+}
+
+static __m128i _expand_128(__m128i key, __m128i assist) {
+    return _expand(key, _mm_shuffle_epi32(assist, 0xff));
+}
+
+/* the 192-bit schedule advances by six words: four in *t1, two in *t3 */
+static void _expand_192(__m128i *t1, __m128i assist, __m128i *t3) {
+    *t1 = _expand(*t1, _mm_shuffle_epi32(assist, 0x55));
+    *t3 = _mm_xor_si128(*t3, _mm_slli_si128(*t3, 4));
+    *t3 = _mm_xor_si128(*t3, _mm_shuffle_epi32(*t1, 0xff));
+}
+
+/* the second half of a 256-bit step uses SubWord without the rotation */
+static __m128i _expand_256b(__m128i t1, __m128i t3) {
+    return _expand(t3, _mm_shuffle_epi32(_mm_aeskeygenassist_si128(t1, 0x00), 0xaa));
+}
+
+static __m128i _pair(__m128i lo, __m128i hi) {
+    return _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(lo), _mm_castsi128_pd(hi), 0));
+}
+
+static __m128i _pair_high(__m128i lo, __m128i hi) {
+    return _mm_castpd_si128(_mm_shuffle_pd(_mm_castsi128_pd(lo), _mm_castsi128_pd(hi), 1));
+}
+
+int aes_ni_set_key(unsigned char *erk, unsigned char *drk, const unsigned char *key, int nbits) {
+    __m128i k[15], t1, t3;
+    int nr;
+
+    switch (nbits) {
+    case 128:
+        nr = 10;
+        k[0] = _mm_loadu_si128((const __m128i *) key);
+#define AES_NI_EXPAND_128(i, rcon) \
+        k[i] = _expand_128(k[i - 1], _mm_aeskeygenassist_si128(k[i - 1], rcon))
+        AES_NI_EXPAND_128(1, 0x01);
+        AES_NI_EXPAND_128(2, 0x02);
+        AES_NI_EXPAND_128(3, 0x04);
+        AES_NI_EXPAND_128(4, 0x08);
+        AES_NI_EXPAND_128(5, 0x10);
+        AES_NI_EXPAND_128(6, 0x20);
+        AES_NI_EXPAND_128(7, 0x40);
+        AES_NI_EXPAND_128(8, 0x80);
+        AES_NI_EXPAND_128(9, 0x1b);
+        AES_NI_EXPAND_128(10, 0x36);
+#undef AES_NI_EXPAND_128
+        break;
+    case 192:
+        nr = 12;
+        t1 = _mm_loadu_si128((const __m128i *) key);
+        t3 = _mm_loadl_epi64((const __m128i *) (key + 16));
+        k[0] = t1;
+        k[1] = t3;
+        _expand_192(&t1, _mm_aeskeygenassist_si128(t3, 0x01), &t3);
+        k[1] = _pair(k[1], t1);
+        k[2] = _pair_high(t1, t3);
+        _expand_192(&t1, _mm_aeskeygenassist_si128(t3, 0x02), &t3);
+        k[3] = t1;
+        k[4] = t3;
+        _expand_192(&t1, _mm_aeskeygenassist_si128(t3, 0x04), &t3);
+        k[4] = _pair(k[4], t1);
+        k[5] = _pair_high(t1, t3);
+        _expand_192(&t1, _mm_aeskeygenassist_si128(t3, 0x08), &t3);
+        k[6] = t1;
+        k[7] = t3;
+        _expand_192(&t1, _mm_aeskeygenassist_si128(t3, 0x10), &t3);
+        k[7] = _pair(k[7], t1);
+        k[8] = _pair_high(t1, t3);
+        _expand_192(&t1, _mm_aeskeygenassist_si128(t3, 0x20), &t3);
+        k[9] = t1;
+        k[10] = t3;
+        _expand_192(&t1, _mm_aeskeygenassist_si128(t3, 0x40), &t3);
+        k[10] = _pair(k[10], t1);
+        k[11] = _pair_high(t1, t3);
+        _expand_192(&t1, _mm_aeskeygenassist_si128(t3, 0x80), &t3);
+        k[12] = t1;
+        break;
+    case 256:
+        nr = 14;
+        k[0] = _mm_loadu_si128((const __m128i *) key);
+        k[1] = _mm_loadu_si128((const __m128i *) (key + 16));
+#define AES_NI_EXPAND_256(i, rcon) \
+        k[i] = _expand_128(k[i - 2], _mm_aeskeygenassist_si128(k[i - 1], rcon)); \
+        if (i < 14) k[i + 1] = _expand_256b(k[i], k[i - 1])
+        AES_NI_EXPAND_256(2, 0x01);
+        AES_NI_EXPAND_256(4, 0x02);
+        AES_NI_EXPAND_256(6, 0x04);
+        AES_NI_EXPAND_256(8, 0x08);
+        AES_NI_EXPAND_256(10, 0x10);
+        AES_NI_EXPAND_256(12, 0x20);
+        AES_NI_EXPAND_256(14, 0x40);
+#undef AES_NI_EXPAND_256
+        break;
+    default:
+        return 0;
+    }
+
+    /* the inverse cipher takes the keys in reverse, through InvMixColumns */
+    for (int i = 0; i <= nr; i++) {
+        __m128i d = (i == 0 || i == nr) ? k[nr - i] : _mm_aesimc_si128(k[nr - i]);
+        _mm_storeu_si128((__m128i *) (erk + 16 * i), k[i]);
+        _mm_storeu_si128((__m128i *) (drk + 16 * i), d);
+    }
+    return nr;
+}
+
+static void _load_keys(__m128i k[15], const unsigned char *rk, int nr) {
+    for (int i = 0; i <= nr; i++)
+        k[i] = _mm_loadu_si128((const __m128i *) (rk + 16 * i));
+}
+
+static __m128i _encrypt1(const __m128i *k, int nr, __m128i b) {
+    b = _mm_xor_si128(b, k[0]);
+    for (int r = 1; r < nr; r++)
+        b = _mm_aesenc_si128(b, k[r]);
+    return _mm_aesenclast_si128(b, k[nr]);
+}
+
+static __m128i _decrypt1(const __m128i *k, int nr, __m128i b) {
+    b = _mm_xor_si128(b, k[0]);
+    for (int r = 1; r < nr; r++)
+        b = _mm_aesdec_si128(b, k[r]);
+    return _mm_aesdeclast_si128(b, k[nr]);
+}
+
+/* each round is applied to all lanes before the next, so that the lanes'
+   instructions are independent and overlap in the pipeline */
+static void _encrypt8(const __m128i *k, int nr, __m128i b[AES_NI_LANES]) {
+    for (int j = 0; j < AES_NI_LANES; j++)
+        b[j] = _mm_xor_si128(b[j], k[0]);
+    for (int r = 1; r < nr; r++)
+        for (int j = 0; j < AES_NI_LANES; j++)
+            b[j] = _mm_aesenc_si128(b[j], k[r]);
+    for (int j = 0; j < AES_NI_LANES; j++)
+        b[j] = _mm_aesenclast_si128(b[j], k[nr]);
+}
+
+static void _decrypt8(const __m128i *k, int nr, __m128i b[AES_NI_LANES]) {
+    for (int j = 0; j < AES_NI_LANES; j++)
+        b[j] = _mm_xor_si128(b[j], k[0]);
+    for (int r = 1; r < nr; r++)
+        for (int j = 0; j < AES_NI_LANES; j++)
+            b[j] = _mm_aesdec_si128(b[j], k[r]);
+    for (int j = 0; j < AES_NI_LANES; j++)
+        b[j] = _mm_aesdeclast_si128(b[j], k[nr]);
+}
+
+void aes_ni_encrypt_ecb(const unsigned char *erk, int nr, const unsigned char *in,
+                        unsigned char *out, size_t nblocks) {
+    __m128i k[15], b[AES_NI_LANES];
+
+    _load_keys(k, erk, nr);
+    for (; nblocks >= AES_NI_LANES; nblocks -= AES_NI_LANES) {
+        for (int j = 0; j < AES_NI_LANES; j++)
+            b[j] = _mm_loadu_si128((const __m128i *) (in + 16 * j));
+        _encrypt8(k, nr, b);
+        for (int j = 0; j < AES_NI_LANES; j++)
+            _mm_storeu_si128((__m128i *) (out + 16 * j), b[j]);
+        in += 16 * AES_NI_LANES;
+        out += 16 * AES_NI_LANES;
+    }
+    for (; nblocks > 0; nblocks--, in += 16, out += 16)
+        _mm_storeu_si128((__m128i *) out,
+                         _encrypt1(k, nr, _mm_loadu_si128((const __m128i *) in)));
+}
+
+void aes_ni_decrypt_ecb(const unsigned char *drk, int nr, const unsigned char *in,
+                        unsigned char *out, size_t nblocks) {
+    __m128i k[15], b[AES_NI_LANES];
+
+    _load_keys(k, drk, nr);
+    for (; nblocks >= AES_NI_LANES; nblocks -= AES_NI_LANES) {
+        for (int j = 0; j < AES_NI_LANES; j++)
+            b[j] = _mm_loadu_si128((const __m128i *) (in + 16 * j));
+        _decrypt8(k, nr, b);
+        for (int j = 0; j < AES_NI_LANES; j++)
+            _mm_storeu_si128((__m128i *) (out + 16 * j), b[j]);
+        in += 16 * AES_NI_LANES;
+        out += 16 * AES_NI_LANES;
+    }
+    for (; nblocks > 0; nblocks--, in += 16, out += 16)
+        _mm_storeu_si128((__m128i *) out,
+                         _decrypt1(k, nr, _mm_loadu_si128((const __m128i *) in)));
+}
+
+/* each block depends on the previous one, so there is nothing to overlap */
+void aes_ni_encrypt_cbc(const unsigned char *erk, int nr, unsigned char iv[16],
+                        const unsigned char *in, unsigned char *out, size_t nblocks) {
+    __m128i k[15];
+    __m128i c = _mm_loadu_si128((const __m128i *) iv);
+
+    _load_keys(k, erk, nr);
+    for (; nblocks > 0; nblocks--, in += 16, out += 16) {
+        c = _encrypt1(k, nr, _mm_xor_si128(c, _mm_loadu_si128((const __m128i *) in)));
+        _mm_storeu_si128((__m128i *) out, c);
+    }
+    _mm_storeu_si128((__m128i *) iv, c);
+}
+
+void aes_ni_decrypt_cbc(const unsigned char *drk, int nr, unsigned char iv[16],
+                        const unsigned char *in, unsigned char *out, size_t nblocks) {
+    __m128i k[15], b[AES_NI_LANES], c[AES_NI_LANES];
+    __m128i prev = _mm_loadu_si128((const __m128i *) iv);
+
+    _load_keys(k, drk, nr);
+    for (; nblocks >= AES_NI_LANES; nblocks -= AES_NI_LANES) {
+        for (int j = 0; j < AES_NI_LANES; j++)
+            b[j] = c[j] = _mm_loadu_si128((const __m128i *) (in + 16 * j));
+        _decrypt8(k, nr, b);
+        _mm_storeu_si128((__m128i *) out, _mm_xor_si128(b[0], prev));
+        for (int j = 1; j < AES_NI_LANES; j++)
+            _mm_storeu_si128((__m128i *) (out + 16 * j), _mm_xor_si128(b[j], c[j - 1]));
+        prev = c[AES_NI_LANES - 1];
+        in += 16 * AES_NI_LANES;
+        out += 16 * AES_NI_LANES;
+    }
+    for (; nblocks > 0; nblocks--, in += 16, out += 16) {
+        __m128i x = _mm_loadu_si128((const __m128i *) in);
+        _mm_storeu_si128((__m128i *) out, _mm_xor_si128(_decrypt1(k, nr, x), prev));
+        prev = x;
+    }
+    _mm_storeu_si128((__m128i *) iv, prev);
+}
+
+static unsigned long long _load_be64(const unsigned char *p) {
+    unsigned long long v = 0;
+    for (int i = 0; i < 8; i++)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static void _store_be64(unsigned char *p, unsigned long long v) {
+    for (int i = 7; i >= 0; i--, v >>= 8)
+        p[i] = (unsigned char) v;
+}
+
+void aes_ni_ctr(const unsigned char *erk, int nr, unsigned char ctr[16],
+                const unsigned char *in, unsigned char *out, size_t len) {
+    /* the counter is kept as two native words, and put into big endian
+       order within each half of the block by the shuffle */
+    const __m128i bswap = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+    unsigned long long hi = _load_be64(ctr), lo = _load_be64(ctr + 8);
+    __m128i k[15], b[AES_NI_LANES];
+
+#define AES_NI_COUNTER(x) do {                                                   \
+        (x) = _mm_shuffle_epi8(_mm_set_epi64x((long long) lo, (long long) hi), bswap); \
+        if (++lo == 0) hi++;                                                     \
+    } while (0)
+
+    _load_keys(k, erk, nr);
+    for (; len >= 16 * AES_NI_LANES; len -= 16 * AES_NI_LANES) {
+        for (int j = 0; j < AES_NI_LANES; j++)
+            AES_NI_COUNTER(b[j]);
+        _encrypt8(k, nr, b);
+        for (int j = 0; j < AES_NI_LANES; j++) {
+            __m128i x = _mm_loadu_si128((const __m128i *) (in + 16 * j));
+            _mm_storeu_si128((__m128i *) (out + 16 * j), _mm_xor_si128(x, b[j]));
+        }
+        in += 16 * AES_NI_LANES;
+        out += 16 * AES_NI_LANES;
+    }
+    for (; len >= 16; len -= 16, in += 16, out += 16) {
+        AES_NI_COUNTER(b[0]);
+        __m128i x = _mm_loadu_si128((const __m128i *) in);
+        _mm_storeu_si128((__m128i *) out, _mm_xor_si128(x, _encrypt1(k, nr, b[0])));
+    }
+    if (len > 0) {
+        unsigned char keystream[16];
+        AES_NI_COUNTER(b[0]);
+        _mm_storeu_si128((__m128i *) keystream, _encrypt1(k, nr, b[0]));
+        for (size_t j = 0; j < len; j++)
+            out[j] = in[j] ^ keystream[j];
+    }
+#undef AES_NI_COUNTER
+
+    _store_be64(ctr, hi);
+    _store_be64(ctr + 8, lo);
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+int aes_ni_available(void) {
+    const int need = CPU_X86_AESNI | CPU_X86_SSSE3;
+    return (cpu_x86_features() & need) == need;
+}
+
+#else
+
+int aes_ni_available(void) {
+    return 0;
+}
+
+#endif
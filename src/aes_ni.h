@@ -0,0 +1,60 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _AES_NI_H
+#define _AES_NI_H
+
+#include <stddef.h>
+
+#include "cpu_features.h"
+
+/* round keys for the AES instructions: nr + 1 blocks of 16 bytes */
+#define AES_NI_KEYS_LEN (15 * 16)
+
+/* non-zero if the CPU has the AES instructions, in which case the functions
+   below may be used; they exist only when DIGEST_X86_SIMD is set */
+int aes_ni_available(void);
+
+#if DIGEST_X86_SIMD
+/* expands key into the encryption round keys erk, and the round keys of the
+   equivalent inverse cipher drk; returns the number of rounds, or 0 if
+   nbits is not 128, 192 or 256 */
+int aes_ni_set_key(unsigned char *erk, unsigned char *drk, const unsigned char *key, int nbits);
+
+/* in and out may be the same buffer in all of these */
+void aes_ni_encrypt_ecb(const unsigned char *erk, int nr, const unsigned char *in,
+                        unsigned char *out, size_t nblocks);
+void aes_ni_decrypt_ecb(const unsigned char *drk, int nr, const unsigned char *in,
+                        unsigned char *out, size_t nblocks);
+/* iv is updated to the last ciphertext block */
+void aes_ni_encrypt_cbc(const unsigned char *erk, int nr, unsigned char iv[16],
+                        const unsigned char *in, unsigned char *out, size_t nblocks);
+void aes_ni_decrypt_cbc(const unsigned char *drk, int nr, unsigned char iv[16],
+                        const unsigned char *in, unsigned char *out, size_t nblocks);
+/* len need not be a multiple of 16; ctr, a big endian 128-bit counter, is
+   advanced once per block started */
+void aes_ni_ctr(const unsigned char *erk, int nr, unsigned char ctr[16],
+                const unsigned char *in, unsigned char *out, size_t len);
+#endif
+
+#endif /* _AES_NI_H */
@@ -21,10 +21,14 @@
 
 */
 
-/* blake3 supports hardware acceleration in the full (upstream)
-   version, but we carry only the 'portable' version so we need to
-   explicitly un-select hardware acceleration on amd64 (SSE*, AVX*)
-   and (recent) arm64 (NEON */
+/* blake3 supports hardware acceleration on amd64 (SSE*, AVX*) and on
+   (recent) arm64 (NEON). We carry the x86 intrinsics versions, each of
+   which enables its instruction set for its own file only, and the
+   dispatcher picks the best one the CPU supports at runtime. Compilers
+   without the needed intrinsics, and other architectures, use the
+   'portable' version. */
+
+#if !(defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5) || defined(_MSC_VER))
 
 #if !defined(BLAKE3_NO_SSE2)
 #define BLAKE3_NO_SSE2
@@ -42,6 +46,14 @@
 #define BLAKE3_NO_AVX512
 #endif
 
+#endif
+
 #if !defined(BLAKE3_USE_NEON)
 #define BLAKE3_USE_NEON 0
 #endif
+
+/* instead of TBB, the subtree compression can be split across the
+   package's own thread pool, see blake3_threads.c */
+#if !defined(BLAKE3_USE_THREADS) && !defined(BLAKE3_USE_TBB)
+#define BLAKE3_USE_THREADS 1
+#endif
@@ -0,0 +1,123 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Counterpart of upstream's blake3_tbb.cpp: the left half of each large
+   subtree is handed to the thread pool while the current thread works on
+   the right half. The tree is the same as in the serial case, so is the
+   hash. The pool in use is kept in a thread-local variable, set for the
+   calling thread by blake3_hasher_update_pool() and for the workers by
+   each task, as the join hook has no other way to receive it. */
+
+#include "blake3_impl.h"
+#include "blake3_threads.h"
+
+#if BLAKE3_USE_THREADS
+
+#if defined(_MSC_VER)
+#define BLAKE3_THREAD_LOCAL __declspec(thread)
+#else
+#define BLAKE3_THREAD_LOCAL __thread
+#endif
+
+/* subtrees below this size are not worth a task of their own */
+#define BLAKE3_THREADS_MIN_LEN ((size_t) 128 * 1024)
+
+static BLAKE3_THREAD_LOCAL thread_pool *blake3_pool = NULL;
+
+typedef struct {
+    pool_task task;
+    thread_pool *pool;
+    const uint8_t *input;
+    size_t input_len;
+    const uint32_t *key;
+    uint64_t chunk_counter;
+    uint8_t flags;
+    uint8_t *cvs;
+    size_t n;
+} subtree_job;
+
+static void _subtree_job_run(void *arg) {
+    subtree_job *job = (subtree_job *) arg;
+    thread_pool *saved = blake3_pool;
+
+    blake3_pool = job->pool;
+    job->n = blake3_compress_subtree_wide(job->input, job->input_len, job->key,
+                                          job->chunk_counter, job->flags, job->cvs,
+                                          true);
+    blake3_pool = saved;
+}
+
+void blake3_compress_subtree_wide_join_threads(
+    const uint32_t key[8], uint8_t flags, bool use_threads,
+    const uint8_t *l_input, size_t l_input_len, uint64_t l_chunk_counter,
+    uint8_t *l_cvs, size_t *l_n,
+    const uint8_t *r_input, size_t r_input_len, uint64_t r_chunk_counter,
+    uint8_t *r_cvs, size_t *r_n) {
+
+    if (!use_threads || blake3_pool == NULL || l_input_len < BLAKE3_THREADS_MIN_LEN) {
+        *l_n = blake3_compress_subtree_wide(l_input, l_input_len, key, l_chunk_counter,
+                                            flags, l_cvs, use_threads);
+        *r_n = blake3_compress_subtree_wide(r_input, r_input_len, key, r_chunk_counter,
+                                            flags, r_cvs, use_threads);
+        return;
+    }
+
+    subtree_job left;
+    left.task.fn = _subtree_job_run;
+    left.task.arg = &left;
+    left.pool = blake3_pool;
+    left.input = l_input;
+    left.input_len = l_input_len;
+    left.key = key;
+    left.chunk_counter = l_chunk_counter;
+    left.flags = flags;
+    left.cvs = l_cvs;
+    thread_pool_submit(blake3_pool, &left.task);
+
+    *r_n = blake3_compress_subtree_wide(r_input, r_input_len, key, r_chunk_counter,
+                                        flags, r_cvs, use_threads);
+    thread_pool_wait(blake3_pool, &left.task);
+    *l_n = left.n;
+}
+
+void blake3_hasher_update_pool(blake3_hasher *self, const void *input,
+                               size_t input_len, thread_pool *pool) {
+    if (pool == NULL) {
+        blake3_hasher_update(self, input, input_len);
+        return;
+    }
+    thread_pool *saved = blake3_pool;
+    blake3_pool = pool;
+    blake3_hasher_update_threads(self, input, input_len);
+    blake3_pool = saved;
+}
+
+#else
+
+void blake3_hasher_update_pool(blake3_hasher *self, const void *input,
+                               size_t input_len, thread_pool *pool) {
+    (void) pool;
+    blake3_hasher_update(self, input, input_len);
+}
+
+#endif
@@ -0,0 +1,35 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _BLAKE3_THREADS_H
+#define _BLAKE3_THREADS_H
+
+#include "blake3.h"
+#include "thread_pool.h"
+
+/* blake3_hasher_update() spreading large inputs over the threads of
+   'pool'; a NULL pool hashes serially. The result is identical either way. */
+void blake3_hasher_update_pool(blake3_hasher *self, const void *input,
+                               size_t input_len, thread_pool *pool);
+
+#endif /* _BLAKE3_THREADS_H */
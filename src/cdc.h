@@ -0,0 +1,82 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _CDC_H
+#define _CDC_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "hasher.h"
+
+/* Content-defined chunking after FastCDC (Xia et al., 2016/2020): a gear
+   hash is rolled over the data from min bytes into each chunk, and a chunk
+   ends where its top bits are zero, or at max bytes. Before avg bytes a
+   mask of two more bits is tested than after it, which narrows the spread
+   of chunk sizes around avg. No R API is used. */
+typedef struct {
+    uint64_t min, avg, max;
+    uint64_t mask_s, mask_l;    /* before and after avg bytes */
+    uint64_t fp;                /* gear hash of the current chunk */
+    uint64_t pos;               /* bytes of the current chunk seen so far */
+} cdc_state;
+
+/* smallest and largest average chunk sizes accepted by cdc_init() */
+#define CDC_AVG_MIN ((uint64_t) 64)
+#define CDC_AVG_MAX ((uint64_t) 1 << 30)
+
+/* avg must be a power of two within the limits above, and
+   min <= avg <= max; returns 0, or -1 for invalid sizes */
+int cdc_init(cdc_state *s, uint64_t min, uint64_t avg, uint64_t max);
+
+/* Returns how many bytes of buf still belong to the current chunk. If the
+   chunk ends within buf, *cut is set to 1 and the state is reset for the
+   next chunk, which starts with the remaining bytes; otherwise all of buf
+   is consumed and *cut is 0. */
+size_t cdc_scan(cdc_state *s, const unsigned char *buf, size_t len, int *cut);
+
+/* splits a stream into chunks and hashes each of them */
+typedef struct {
+    cdc_state cdc;
+    digest_hasher hasher;
+    int algo;
+    uint32_t seed;
+    int output_length;
+    uint64_t offset;            /* of the current chunk in the stream */
+    size_t n, size;             /* chunks found, and room for them */
+    uint64_t *offsets, *lengths;
+    unsigned char *digests;     /* n * output_length bytes */
+    int failed;                 /* out of memory */
+} cdc_digest;
+
+/* returns the digest length, or -1 for an unsupported algorithm or
+   invalid chunk sizes */
+int cdc_digest_init(cdc_digest *d, int algo, uint32_t seed,
+                    uint64_t min, uint64_t avg, uint64_t max);
+/* consumes the next bytes of the stream; in the shape of a file_reader callback */
+void cdc_digest_update(void *data, const unsigned char *buf, size_t len);
+/* ends the last chunk; returns 0, or -1 if memory ran out on the way */
+int cdc_digest_final(cdc_digest *d);
+void cdc_digest_free(cdc_digest *d);
+
+#endif /* _CDC_H */
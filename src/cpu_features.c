@@ -0,0 +1,99 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "cpu_features.h"
+
+#if DIGEST_X86_SIMD
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+static void _cpuid(unsigned int out[4], unsigned int leaf) {
+#if defined(_MSC_VER)
+    __cpuidex((int *) out, (int) leaf, 0);
+#else
+    __cpuid_count(leaf, 0, out[0], out[1], out[2], out[3]);
+#endif
+}
+
+/* the register state enabled by the OS, as reported by XGETBV */
+static unsigned long long _cpu_xcr0(void) {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax, edx;
+    __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long) edx << 32) | eax;
+#endif
+}
+
+static int _cpu_x86_detect(void) {
+    unsigned int regs[4];
+    int features = 0;
+
+    _cpuid(regs, 0);
+    if (regs[0] < 1) return 0;
+    unsigned int max_leaf = regs[0];
+
+    _cpuid(regs, 1);
+    if (regs[2] & (1u << 9))  features |= CPU_X86_SSSE3;
+    if (regs[2] & (1u << 19)) features |= CPU_X86_SSE41;
+    if (regs[2] & (1u << 20)) features |= CPU_X86_SSE42;
+    if (regs[2] & (1u << 1))  features |= CPU_X86_PCLMUL;
+    if (regs[2] & (1u << 25)) features |= CPU_X86_AESNI;
+    /* OSXSAVE; XCR0 bits 1-2 are the XMM and YMM state, 5-7 the ZMM state */
+    unsigned long long xcr0 = (regs[2] & (1u << 27)) ? _cpu_xcr0() : 0;
+
+    if (max_leaf >= 7) {
+        _cpuid(regs, 7);
+        if (regs[1] & (1u << 29)) features |= CPU_X86_SHA;
+        if ((regs[1] & (1u << 5)) && (xcr0 & 0x06) == 0x06)
+            features |= CPU_X86_AVX2;
+        if ((regs[1] & (1u << 16)) && (xcr0 & 0xe6) == 0xe6)
+            features |= CPU_X86_AVX512;
+    }
+    return features;
+}
+
+/* a racing first call merely detects the same value twice */
+static volatile int cpu_features_cached = -1;
+
+int cpu_x86_features(void) {
+    int features = cpu_features_cached;
+    if (features < 0) {
+        features = _cpu_x86_detect();
+        cpu_features_cached = features;
+    }
+    return features;
+}
+
+#else
+
+int cpu_x86_features(void) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,51 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _CPU_FEATURES_H
+#define _CPU_FEATURES_H
+
+/* The accelerated x86 kernels enable their instruction sets per file via
+   target pragmas, so that the package itself can still be built with the
+   default flags; they are only compiled on x86-64 with compilers known to
+   support this, and only called after checking the CPU at runtime. */
+#if (defined(__x86_64__) || defined(_M_X64)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5) || defined(_MSC_VER))
+#define DIGEST_X86_SIMD 1
+#else
+#define DIGEST_X86_SIMD 0
+#endif
+
+#define CPU_X86_SSSE3   (1 << 0)
+#define CPU_X86_SSE41   (1 << 1)
+#define CPU_X86_SSE42   (1 << 2)
+#define CPU_X86_PCLMUL  (1 << 3)
+#define CPU_X86_AESNI   (1 << 4)
+#define CPU_X86_SHA     (1 << 5)
+#define CPU_X86_AVX2    (1 << 6)    /* with OS support for the YMM state */
+#define CPU_X86_AVX512  (1 << 7)    /* AVX-512F, with OS support for the ZMM state */
+
+/* bitmask of the features above, detected once; always 0 when
+   DIGEST_X86_SIMD is not set */
+int cpu_x86_features(void);
+
+#endif /* _CPU_FEATURES_H */
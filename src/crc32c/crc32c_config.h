@@ -22,7 +22,14 @@
 
 // Define to 1 if targeting X86 and the compiler has the _mm_crc32_u{8,32,64}
 // intrinsics.
+// edd 2026  Enabled for compilers that can target SSE4.2 per function, as
+//           crc32c_sse42.cpp does; use is decided at runtime via cpuid
+#if (defined(_M_X64) || defined(__x86_64__)) && \
+    (defined(__clang__) || (defined(__GNUC__) && __GNUC__ >= 5) || defined(_MSC_VER))
+#define HAVE_SSE42 1
+#else
 #define HAVE_SSE42 0
+#endif
 
 // Define to 1 if targeting ARM and the compiler has the __crc32c{b,h,w,d} and
 // the vmull_p64 intrinsics.
@@ -25,6 +25,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <limits.h>
 
 #include <Rdefines.h>
 #include <Rinternals.h>
@@ -41,37 +42,17 @@
 #include "pmurhash.h"
 #include "blake3.h"
 #include "crc32c.h"
-
-#ifdef _WIN32
-#include <Windows.h>
-#endif
+#include "hasher.h"
+#include "file_reader.h"
+#include "blake3_threads.h"
+#include "hash_batch.h"
+#include "hex.h"
+#include "cdc.h"
+#include "rolling.h"
 
 unsigned long ZEXPORT digest_crc32(unsigned long crc,
                                    const unsigned char FAR *buf,
-                                   unsigned len);
-
-FILE* open_with_widechar_on_windows(const unsigned char* txt) {
-    FILE* out;
-#ifdef _WIN32
-    wchar_t* buf;
-    size_t len = MultiByteToWideChar(CP_UTF8, 0, (char *)txt, -1, NULL, 0);
-    if (len <= 0) {
-        error("Cannot convert file to Unicode: %s", txt);
-    }
-    buf = (wchar_t*) R_alloc(len, sizeof(wchar_t));
-    if (buf == NULL) {
-        error("Could not allocate buffer of size: %llu", len);
-    }
-
-    MultiByteToWideChar(CP_UTF8, 0, (char *)txt, -1, buf, len);
-    out = _wfopen(buf, L"rb");
-#else
-    out = fopen((char *)txt, "rb");
-#endif
-
-    return out;
-}
-
+                                   size_t len);
 
 // Also already used in sha2.h
 //
@@ -102,37 +83,14 @@ SEXP is_little_endian(void) {
     return Rf_ScalarLogical(BYTE_ORDER == LITTLE_ENDIAN);
 }
 
-#ifndef USESHA512
-#define USESHA512 0
-#endif
-
-#if USESHA512
-static const char *sha2_hex_digits = "0123456789abcdef";
-#endif
-
-// USESHA512 seems maybe faster? however, more complex, not obviously faster
+// digests are stored as raw bytes or as NUL-terminated hex, see hex.c
 void _store_from_char_ptr(const unsigned char * hash, char * const output,
                           const size_t output_length, const int leaveRaw) {
     if (leaveRaw) {
         memcpy(output, hash, output_length);
     } else {
-#if USESHA512
-        char *outputp = output;
-        unsigned const char *d = hash;
-#endif
-        for (int j = 0; j < output_length; j++) {
-#if USESHA512
-            *outputp++ = sha2_hex_digits[(*d & 0xf0) >> 4];
-            *outputp++ = sha2_hex_digits[*d & 0x0f];
-            d++;
-#else
-            // a char = 2 hex digits => to (0-9A-F)-charset = writing 2 spots
-            snprintf(output + j * 2, 3, "%02x", hash[j]);
-#endif
-        }
-#if USESHA512
-        *outputp = (char)0;
-#endif
+        hex_encode(output, hash, output_length);
+        output[2 * output_length] = '\0';
     }
 }
 
@@ -144,32 +102,156 @@ void rev_memcpy(char *dst, const void *src, int len) {
 
 // n.b. ripe templating to e.g. _store_from_integral<> if switching to c++
 void _store_from_int32(const uint32_t hash, char *output, const int leaveRaw) {
-    if (leaveRaw) {
+    unsigned char bytes[sizeof(uint32_t)];
 #if BYTE_ORDER == LITTLE_ENDIAN
-        rev_memcpy(output, &hash, sizeof(uint32_t));
+    rev_memcpy((char *) bytes, &hash, sizeof(uint32_t));
 #else
-        memcpy(output, &hash, sizeof(uint32_t));
+    memcpy(bytes, &hash, sizeof(uint32_t));
 #endif
-    } else snprintf(output, sizeof(uint32_t)*2 + 1, "%08x", hash);
+    _store_from_char_ptr(bytes, output, sizeof(uint32_t), leaveRaw);
 }
 
 void _store_from_int64(const uint64_t hash, char *output, const int leaveRaw) {
-    if (leaveRaw) {
+    unsigned char bytes[sizeof(uint64_t)];
 #if BYTE_ORDER == LITTLE_ENDIAN
-        rev_memcpy(output, &hash, sizeof(uint64_t));
+    rev_memcpy((char *) bytes, &hash, sizeof(uint64_t));
 #else
-        memcpy(output, &hash, sizeof(uint64_t));
+    memcpy(bytes, &hash, sizeof(uint64_t));
 #endif
-    } else snprintf(output, sizeof(uint64_t)*2 + 1, "%016" PRIx64, hash);
+    _store_from_char_ptr(bytes, output, sizeof(uint64_t), leaveRaw);
 }
 
-SEXP digest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Leave_raw, SEXP Seed) {
-    size_t BUF_SIZE = 1024;
-    FILE *fp=0;
+// wrap a digest in canonical byte order as the raw vector or hex string returned to R
+SEXP _digest_result(const unsigned char *hash, const int output_length, const int leaveRaw) {
+    char output[128+1];
+    SEXP result = R_NilValue;
+
+    _store_from_char_ptr(hash, output, output_length, leaveRaw);
+    if (leaveRaw) {
+        PROTECT(result=allocVector(RAWSXP, output_length));
+        memcpy(RAW(result), output, output_length);
+    } else {
+        PROTECT(result=allocVector(STRSXP, 1));
+        SET_STRING_ELT(result, 0, mkCharLenCE(output, 2 * output_length, CE_NATIVE));
+    }
+    UNPROTECT(1);
+
+    return result;
+}
+
+// vdigest() results: hex strings, an n x k raw matrix holding one digest
+// per row, or for digests of up to 64 bits one number per element; the
+// latter two are filled in place, without an R object per element
+SEXP _vdigest_alloc(const R_xlen_t n, const int output_length, const int output) {
+    SEXP ans;
+
+    switch (output) {
+    case VDIGEST_OUTPUT_RAW:
+        if (n > INT_MAX)
+            error("Too many elements for a raw matrix");
+        PROTECT(ans = allocMatrix(RAWSXP, (int) n, output_length));
+        break;
+    case VDIGEST_OUTPUT_NUMERIC:
+        if (output_length != 4 && output_length != 8)
+            error("Numeric output requires a digest of 32 or 64 bits");
+        PROTECT(ans = allocVector(REALSXP, n));
+        // 64 bit values keep their bits, as the integer64 class of bit64 does
+        if (output_length == 8) setAttrib(ans, R_ClassSymbol, mkString("integer64"));
+        break;
+    default:
+        PROTECT(ans = allocVector(STRSXP, n));
+    }
+    UNPROTECT(1);
+    return ans;
+}
+
+void _vdigest_store(SEXP ans, const R_xlen_t i, const unsigned char *hash,
+                    const int output_length, const int output) {
+    char buf[128+1];
+
+    switch (output) {
+    case VDIGEST_OUTPUT_RAW: {
+        R_xlen_t n = XLENGTH(ans) / output_length;
+        Rbyte *p = RAW(ans) + i;
+        for (int j = 0; j < output_length; j++, p += n) *p = hash[j];
+        break;
+    }
+    case VDIGEST_OUTPUT_NUMERIC: {
+        uint64_t v = 0;
+        for (int j = 0; j < output_length; j++) v = (v << 8) | hash[j];
+        if (output_length == 8) memcpy(REAL(ans) + i, &v, sizeof(double));
+        else REAL(ans)[i] = (double) v;
+        break;
+    }
+    default: {
+        // only the extendable output of blake3 can be longer
+        char *output_hex = output_length <= 64 ? buf : R_alloc(2 * output_length + 1, 1);
+        _store_from_char_ptr(hash, output_hex, output_length, 0);
+        SET_STRING_ELT(ans, i, mkCharLenCE(output_hex, 2 * output_length, CE_NATIVE));
+    }
+    }
+}
+
+// stores n consecutive digests from out into ans[start], ...; hex strings
+// are encoded a block at a time, so that the SIMD encoders see long runs
+void _vdigest_store_batch(SEXP ans, const R_xlen_t start, const unsigned char *out,
+                          const size_t n, const int output_length, const int output) {
+    char hex[2 * 4096];
+    size_t per_block = sizeof(hex) / (2 * (size_t) output_length);
+
+    if (output != VDIGEST_OUTPUT_HEX || per_block == 0) {
+        for (size_t i = 0; i < n; i++)
+            _vdigest_store(ans, start + (R_xlen_t) i, out + i * output_length,
+                           output_length, output);
+        return;
+    }
+    for (size_t i = 0; i < n; i += per_block) {
+        size_t m = n - i < per_block ? n - i : per_block;
+        hex_encode(hex, out + i * output_length, m * output_length);
+        for (size_t j = 0; j < m; j++)
+            SET_STRING_ELT(ans, start + (R_xlen_t) (i + j),
+                           mkCharLenCE(hex + 2 * j * output_length, 2 * output_length,
+                                       CE_NATIVE));
+    }
+}
+
+// lengths and offsets come in as doubles to allow for more than 2^31 bytes;
+// NA and negative values become -1
+int64_t _as_count(SEXP x) {
+    double v = NUMERIC_VALUE(x);
+    return (ISNAN(v) || v < 0) ? -1 : (int64_t) v;
+}
+
+// files are memory mapped only under options(digestFileMmap=TRUE); read
+// at the start of every call reading files, before any thread is started
+void _digest_file_options(void) {
+    file_reader_set_mmap(asLogical(GetOption1(install("digestFileMmap"))) == TRUE);
+}
+
+// applies skip and length to an in-memory input
+static void _skip_and_truncate(unsigned char **txt, R_xlen_t *nChar,
+                               const int64_t skip, const int64_t length) {
+    if (skip > 0) {
+        if (skip >= *nChar) {
+            *nChar = 0;                                                         /* #nocov */
+        } else {
+            *nChar -= skip;
+            *txt += skip;
+        }
+    }
+    if (length >= 0 && length < *nChar) *nChar = length;
+}
+
+// only inputs of at least this size are spread over several threads
+#define DIGEST_THREADS_MIN_LEN ((R_xlen_t) 1 << 20)
+
+SEXP digest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Leave_raw, SEXP Seed,
+            SEXP Chunk_size, SEXP Threads) {
     unsigned char *txt;
     int algo = INTEGER_VALUE(Algo);
-    int length = INTEGER_VALUE(Length);
-    int skip = INTEGER_VALUE(Skip);
+    int threads = INTEGER_VALUE(Threads);
+    int64_t length = _as_count(Length);
+    int64_t skip = _as_count(Skip);
     int seed = INTEGER_VALUE(Seed);
     int leaveRaw = INTEGER_VALUE(Leave_raw);
     SEXP result = R_NilValue;
@@ -187,22 +269,40 @@ SEXP digest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Leave_raw, SEXP Se
         txt = (unsigned char*) STRING_VALUE(Txt);
         nChar = strlen((char *)txt);
 
-        if (algo >= 100) {
-            fp = open_with_widechar_on_windows(txt);
-            if (!fp)  {
-              error("Cannot open input file: %s", txt);  /* #nocov */
+        if (algo >= 100) {      /* all file cases share the reader and hashers */
+            digest_hasher hasher;
+            unsigned char hash[HASHER_MAX_OUTPUT];
+            int64_t chunk = _as_count(Chunk_size);  /* 0 or NA for the default */
+            size_t chunk_size = chunk > 0 ? (size_t) chunk : 0;
+
+            int status;
+
+            _digest_file_options();
+            output_length = hasher_init(&hasher, algo - 100, (uint32_t) seed);
+            if (output_length < 0) {
+                error("Unsupported algorithm code"); /* should not be reached due to test in R */ /* #nocov */
             }
+            if (algo == 110 && threads > 1) {
+                /* larger windows give each thread a share of every update */
+                hasher.pool = thread_pool_create(threads);
+                if (chunk_size == 0) chunk_size = FILE_READER_CHUNK_SIZE;
+                chunk_size *= thread_pool_size(hasher.pool);
+            }
+            status = file_reader_run((const char *) txt, skip, length, chunk_size,
+                                     hasher_update_chunk, &hasher);
+            thread_pool_destroy(hasher.pool);
+            switch (status) {
+            case FILE_READER_EOPEN:
+                error("Cannot open input file: %s", txt);  /* #nocov */
+            case FILE_READER_EREAD:
+                error("Cannot read input file: %s", txt);  /* #nocov */
+            }
+            hasher_final(&hasher, hash);
+
+            return _digest_result(hash, output_length, leaveRaw);
         }
     }
-    if (skip > 0 && algo < 100) {
-        if (skip>=nChar) {
-            nChar=0;                                                            /* #nocov */
-        } else {
-            nChar -= skip;
-            txt += skip;
-        }
-    }
-    if (length>=0 && length<nChar) nChar = length;
+    _skip_and_truncate(&txt, &nChar, skip, length);
 
     switch (algo) {
     case 1: {     /* md5 case */
@@ -231,11 +331,10 @@ SEXP digest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Leave_raw, SEXP Se
     }
     case 3: {     /* crc32 case */
         unsigned long val;
-        unsigned l = nChar;
         output_length = sizeof(unsigned int);
 
         val  = digest_crc32(0L, 0, 0);
-        val  = digest_crc32(val, txt, l);
+        val  = digest_crc32(val, txt, nChar);
 
         _store_from_int32(val, output, leaveRaw);
         break;
@@ -294,10 +393,13 @@ SEXP digest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Leave_raw, SEXP Se
         output_length = BLAKE3_OUT_LEN;
         uint8_t val[output_length];
         blake3_hasher hasher;
+        thread_pool *pool = (threads > 1 && nChar >= DIGEST_THREADS_MIN_LEN)
+            ? thread_pool_create(threads) : NULL;
 
         blake3_hasher_init(&hasher);
-        blake3_hasher_update(&hasher, txt, nChar);
+        blake3_hasher_update_pool(&hasher, txt, nChar, pool);
         blake3_hasher_finalize(&hasher, val, output_length);
+        thread_pool_destroy(pool);
 
         _store_from_char_ptr(val, output, output_length, leaveRaw);
         break;
@@ -323,379 +425,501 @@ SEXP digest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Leave_raw, SEXP Se
         output_length = 16;
 
         XXH128_hash_t val =  XXH3_128bits_withSeed(txt, nChar, seed);
+        XXH128_canonical_t canon;
+        XXH128_canonicalFromHash(&canon, val);
 
-        if (leaveRaw) {
-            XXH128_canonical_t canon;
-            XXH128_canonicalFromHash(&canon, val);
-            memcpy(output, &canon, 16);
-        } else {
-            snprintf(output, 128, "%016" PRIx64 "%016" PRIx64, val.high64, val.low64);
-        }
+        _store_from_char_ptr(canon.digest, output, output_length, leaveRaw);
         break;
     }
-    case 101: {     /* md5 file case */
-        md5_context ctx;
-        output_length = 16;
-        unsigned char buf[BUF_SIZE];
-        unsigned char md5sum[output_length];
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
-
-        md5_starts( &ctx );
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0
-                   && length>0) {
-                if (nChar>length) nChar=length;
-                md5_update( &ctx, buf, nChar );
-                length -= nChar;
-            }
-        } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0)
-                md5_update( &ctx, buf, nChar );
-        }
-        md5_finish( &ctx, md5sum );
-
-        _store_from_char_ptr(md5sum, output, output_length, leaveRaw);
-        break;
+    default: {
+        error("Unsupported algorithm code"); /* should not be reached due to test in R */ /* #nocov */
     }
-    case 102: {     /* sha1 file case */
-        sha1_context ctx;
-        output_length = 20;
-        unsigned char buf[BUF_SIZE];
-        unsigned char sha1sum[output_length];
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
-
-        sha1_starts ( &ctx );
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0 && length>0) {
-                if (nChar>length) nChar=length;
-                sha1_update( &ctx, buf, nChar );
-                length -= nChar;
-            }
-        } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0)
-                sha1_update( &ctx, buf, nChar );
-        }
-        sha1_finish ( &ctx, sha1sum );
+    } /* end switch */
 
-        _store_from_char_ptr(sha1sum, output, output_length, leaveRaw);
-        break;
+    if (leaveRaw) {
+        PROTECT(result=allocVector(RAWSXP, output_length));
+        memcpy(RAW(result), output, output_length);
+    } else {
+        PROTECT(result=allocVector(STRSXP, 1));
+        SET_STRING_ELT(result, 0, mkCharLenCE(output, 2 * output_length, CE_NATIVE));
     }
-    case 103: {     /* crc32 file case */
-        unsigned char buf[BUF_SIZE];
-        unsigned long val;
-        output_length = 4;
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
+    UNPROTECT(1);
 
-        val  = digest_crc32(0L, 0, 0);
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0 && length>0) {
-                if (nChar>length) nChar=length;
-                val  = digest_crc32(val , buf, (unsigned) nChar);
-                length -= nChar;
-            }
-        } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0)
-                val  = digest_crc32(val , buf, (unsigned) nChar);
-        }
+    return result;
+}
 
-        _store_from_int32(val, output, leaveRaw);
-        break;
+
+// elements are gathered, hashed and turned into R strings in batches of
+// this many per thread
+#define VDIGEST_BATCH_PER_THREAD ((R_xlen_t) 1 << 16)
+
+// whether every element is a raw vector, as from serialize_() under pqR
+static int _is_raw_list(SEXP Txt) {
+    R_xlen_t n = XLENGTH(Txt);
+    for (R_xlen_t i = 0; i < n; i++)
+        if (TYPEOF(VECTOR_ELT(Txt, i)) != RAWSXP) return 0;
+    return 1;
+}
+
+// The inputs of a batch are collected here, then hashed by hash_batch_run()
+// without touching any R object, possibly on several threads, after which
+// the digests are stored here again. The pool only lives for the hashing,
+// so that nothing is left running should an R error occur in between.
+// A start state, as prepared for the blake3 modes, replaces the algorithm
+// and seed, and comes with its output length.
+static SEXP _vdigest_batched(SEXP Txt, const int algo, const int64_t length,
+                             const int64_t skip, const int seed, const size_t chunk_size,
+                             const int threads, const int output,
+                             const digest_hasher *start, const int output_length) {
+    R_xlen_t n = XLENGTH(Txt);
+    R_xlen_t batch = VDIGEST_BATCH_PER_THREAD * (threads > 1 ? threads : 1);
+    digest_hasher probe;
+    hash_batch b;
+
+    b.start = start;
+    b.output_length = start != NULL ? output_length
+        : hasher_init(&probe, algo >= 100 ? algo - 100 : algo, (uint32_t) seed);
+    if (b.output_length < 0) {
+        error("Unsupported algorithm code"); /* should not be reached due to test in R */ /* #nocov */
     }
-    case 104: {     /* sha256 file case */
-        sha256_context ctx;
-        output_length = 32;
-        unsigned char buf[BUF_SIZE];
-        unsigned char sha256sum[output_length];
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
-
-        sha256_starts ( &ctx );
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0 && length>0) {
-                if (nChar>length) nChar=length;
-                sha256_update( &ctx, buf, nChar );
-                length -= nChar;
+    if (batch > n) batch = n;
+    if (algo >= 100) _digest_file_options();
+    b.algo = algo;
+    b.seed = (uint32_t) seed;
+    b.skip = skip;
+    b.length = length;
+    b.io_threads = 0;
+    b.chunk_size = chunk_size;
+    b.msgs = (const unsigned char **) R_alloc(batch, sizeof(*b.msgs));
+    size_t *lens = (size_t *) R_alloc(batch, sizeof(*lens));
+    b.lens = lens;
+    b.out = (unsigned char *) R_alloc(batch, b.output_length);
+    b.status = (int *) R_alloc(batch, sizeof(*b.status));
+
+    SEXP ans = PROTECT(_vdigest_alloc(n, b.output_length, output));
+    for (R_xlen_t start = 0; start < n; start += batch) {
+        b.n = (size_t) (n - start < batch ? n - start : batch);
+        for (size_t i = 0; i < b.n; i++) {
+            unsigned char *txt;
+            R_xlen_t nChar;
+            if (TYPEOF(Txt) == STRSXP) {
+                SEXP elt = STRING_ELT(Txt, start + i);
+                txt = (unsigned char *) CHAR(elt);
+                nChar = LENGTH(elt);
+            } else {
+                SEXP elt = VECTOR_ELT(Txt, start + i);
+                txt = RAW(elt);
+                nChar = XLENGTH(elt);
             }
-        } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0)
-                sha256_update( &ctx, buf, nChar );
+            if (algo < 100) _skip_and_truncate(&txt, &nChar, skip, length);
+            b.msgs[i] = txt;
+            lens[i] = (size_t) nChar;
         }
-        sha256_finish ( &ctx, sha256sum );
 
-        _store_from_char_ptr(sha256sum, output, output_length, leaveRaw);
-        break;
-    }
-    case 105: {     /* sha2-512 file case */
-        SHA512_CTX ctx;
-        output_length = SHA512_DIGEST_LENGTH;
-        uint8_t sha512sum[output_length];
-        unsigned char buf[BUF_SIZE];
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
+        thread_pool *pool = b.n > 1 ? thread_pool_create(threads) : NULL;
+        hash_batch_run(&b, pool);
+        thread_pool_destroy(pool);
 
-        SHA512_Init(&ctx);
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0 && length>0) {
-                if (nChar>length) nChar=length;
-                SHA512_Update( &ctx, buf, nChar );
-                length -= nChar;
+        for (size_t i = 0; algo >= 100 && i < b.n; i++) {
+            switch (b.status[i]) {
+            case FILE_READER_EOPEN:
+                error("Cannot open input file: %s", b.msgs[i]);  /* #nocov */
+            case FILE_READER_EREAD:
+                error("Cannot read input file: %s", b.msgs[i]);  /* #nocov */
             }
-        } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0)
-                SHA512_Update( &ctx, buf, nChar );
         }
-        /* Calling SHA512_Final, because SHA512_End will already
-           convert the hash to a string, and we also want RAW */
-        SHA512_Final(sha512sum, &ctx);
+        _vdigest_store_batch(ans, start, b.out, b.n, b.output_length, output);
+    }
+    UNPROTECT(1);
+    return ans;
+}
 
-        _store_from_char_ptr(sha512sum, output, output_length, leaveRaw);
-        break;
+SEXP vdigest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Output, SEXP Seed,
+             SEXP Chunk_size, SEXP Threads){
+    R_xlen_t n = length(Txt);
+    int output = INTEGER_VALUE(Output);
+    if (TYPEOF(Txt) == STRSXP || (TYPEOF(Txt) == VECSXP && _is_raw_list(Txt))) {
+        int64_t chunk = _as_count(Chunk_size);  /* 0 or NA for the default */
+        return _vdigest_batched(Txt, INTEGER_VALUE(Algo), _as_count(Length), _as_count(Skip),
+                                INTEGER_VALUE(Seed), chunk > 0 ? (size_t) chunk : 0,
+                                INTEGER_VALUE(Threads), output, NULL, 0);
+    }
+    if (TYPEOF(Txt) == RAWSXP && output != VDIGEST_OUTPUT_HEX) {
+        SEXP leave_raw = PROTECT(ScalarInteger(1));
+        SEXP d = PROTECT(digest(Txt, Algo, Length, Skip, leave_raw, Seed, Chunk_size, Threads));
+        SEXP ans = PROTECT(_vdigest_alloc(1, LENGTH(d), output));
+        _vdigest_store(ans, 0, RAW(d), LENGTH(d), output);
+        UNPROTECT(3);
+        return ans;
     }
-    case 106: {     /* xxhash32 */
-        unsigned char buf[BUF_SIZE];
-        XXH32_state_t* const state = XXH32_createState();
-        output_length = 4;
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
+    if (TYPEOF(Txt) == RAWSXP || n == 0)
+        return(digest(Txt, Algo, Length, Skip, Output, Seed, Chunk_size, Threads));
+    if (output != VDIGEST_OUTPUT_HEX)
+        error("Raw and numeric output need character or raw input");  /* #nocov */
+    SEXP ans = PROTECT(allocVector(STRSXP, n));
+    SEXP d = R_NilValue;
+    for (R_xlen_t i = 0; i < n; i++){
+        d = digest(VECTOR_ELT(Txt, i), Algo, Length, Skip, Output, Seed, Chunk_size, Threads);
+        SET_STRING_ELT(ans, i, STRING_ELT(d, 0));
+    }
+    UNPROTECT(1);
+    return ans;
+}
 
-        XXH_errorcode const resetResult = XXH32_reset(state, seed);
-        if (resetResult == XXH_ERROR) {
-            error("Error in `XXH32_reset()`"); 				/* #nocov */
+// The files are hashed as by vdigest(file=TRUE), but one that cannot be
+// opened or read gets a missing result and its FILE_READER_* code in the
+// "status" attribute instead of raising an error, so that one bad path
+// does not cost the digests of all others. At most io_threads files are
+// read at the same time; the pool has as many threads as either limit asks.
+SEXP digest_files(SEXP Paths, SEXP Algo, SEXP Length, SEXP Skip, SEXP Seed,
+                  SEXP Chunk_size, SEXP Threads, SEXP Io_threads, SEXP Output) {
+    R_xlen_t n = XLENGTH(Paths);
+    int algo = INTEGER_VALUE(Algo), output = INTEGER_VALUE(Output);
+    int threads = INTEGER_VALUE(Threads), io_threads = INTEGER_VALUE(Io_threads);
+    int64_t chunk = _as_count(Chunk_size);  /* 0 or NA for the default */
+    digest_hasher probe;
+    hash_batch b;
+
+    if (TYPEOF(Paths) != STRSXP)
+        error("Paths must be a character vector");  /* #nocov */
+    b.output_length = hasher_init(&probe, algo, (uint32_t) INTEGER_VALUE(Seed));
+    if (b.output_length < 0) {
+        error("Unsupported algorithm code"); /* should not be reached due to test in R */ /* #nocov */
+    }
+    _digest_file_options();
+    if (threads < 1) threads = 1;
+    if (io_threads < 1 || io_threads == NA_INTEGER) io_threads = threads;
+    if (io_threads > threads) threads = io_threads;
+
+    R_xlen_t batch = VDIGEST_BATCH_PER_THREAD * threads;
+    if (batch > n) batch = n;
+    b.algo = algo + 100;
+    b.seed = (uint32_t) INTEGER_VALUE(Seed);
+    b.skip = _as_count(Skip);
+    b.length = _as_count(Length);
+    b.io_threads = io_threads;
+    b.start = NULL;
+    b.chunk_size = chunk > 0 ? (size_t) chunk : 0;
+    b.msgs = (const unsigned char **) R_alloc(batch, sizeof(*b.msgs));
+    b.lens = NULL;
+    b.out = (unsigned char *) R_alloc(batch, b.output_length);
+    b.status = (int *) R_alloc(batch, sizeof(*b.status));
+
+    SEXP ans = PROTECT(_vdigest_alloc(n, b.output_length, output));
+    SEXP status = PROTECT(allocVector(INTSXP, n));
+    for (R_xlen_t start = 0; start < n; start += batch) {
+        b.n = (size_t) (n - start < batch ? n - start : batch);
+        for (size_t i = 0; i < b.n; i++) {
+            SEXP path = STRING_ELT(Paths, start + i);
+            b.msgs[i] = (const unsigned char *) (path == NA_STRING ? "" : CHAR(path));
         }
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0 && length>0) {
-                if (nChar>length) nChar=length;
-                XXH_errorcode const updateResult = XXH32_update(state, buf, nChar);
-                if (updateResult == XXH_ERROR) {
-                  error("Error in `XXH32_update()`"); 		/* #nocov */
-                }
-                length -= nChar;
-            }
-        } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0) {
-                XXH_errorcode const updateResult = XXH32_update(state, buf, nChar);
-                if (updateResult == XXH_ERROR) {
-                    error("Error in `XXH32_update()`");	 		/* #nocov */
+
+        thread_pool *pool = b.n > 1 ? thread_pool_create(threads) : NULL;
+        hash_batch_run(&b, pool);
+        thread_pool_destroy(pool);
+
+        _vdigest_store_batch(ans, start, b.out, b.n, b.output_length, output);
+        for (size_t i = 0; i < b.n; i++) {
+            R_xlen_t k = start + i;
+            INTEGER(status)[k] = b.status[i];
+            if (b.status[i] == FILE_READER_OK) continue;
+            switch (output) {
+            case VDIGEST_OUTPUT_RAW:
+                for (int j = 0; j < b.output_length; j++) RAW(ans)[k + j * n] = 0;
+                break;
+            case VDIGEST_OUTPUT_NUMERIC:
+                if (b.output_length == 8) {     /* NA of integer64 */
+                    int64_t na = INT64_MIN;
+                    memcpy(REAL(ans) + k, &na, sizeof(double));
+                } else {
+                    REAL(ans)[k] = NA_REAL;
                 }
+                break;
+            default:
+                SET_STRING_ELT(ans, k, NA_STRING);
             }
         }
-        XXH32_hash_t val =  XXH32_digest(state);
-        XXH32_freeState(state);
-
-        _store_from_int32(val, output, leaveRaw);
-        break;
     }
-    case 107: {     /* xxhash64 */
-        unsigned char buf[BUF_SIZE];
-        XXH64_state_t* const state = XXH64_createState();
-        output_length = 8;
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
+    setAttrib(ans, install("status"), status);
+    UNPROTECT(2);
+    return ans;
+}
 
-        XXH_errorcode const resetResult = XXH64_reset(state, seed);
-        if (resetResult == XXH_ERROR) {
-            error("Error in `XXH64_reset()`"); 				/* #nocov */
+// what digest_tree() needs to know of each file: a key for its digest
+// cache, its permission bits and its modification time, NA on failure
+SEXP digest_stat(SEXP Paths) {
+    R_xlen_t n = XLENGTH(Paths);
+    char key[128];
+
+    if (TYPEOF(Paths) != STRSXP)
+        error("Paths must be a character vector");  /* #nocov */
+    SEXP keys = PROTECT(allocVector(STRSXP, n));
+    SEXP modes = PROTECT(allocVector(INTSXP, n));
+    SEXP mtimes = PROTECT(allocVector(REALSXP, n));
+    for (R_xlen_t i = 0; i < n; i++) {
+        SEXP path = STRING_ELT(Paths, i);
+        file_reader_stat_t st;
+
+        if (path == NA_STRING || file_reader_stat(CHAR(path), &st) != FILE_READER_OK) {
+            SET_STRING_ELT(keys, i, NA_STRING);
+            INTEGER(modes)[i] = NA_INTEGER;
+            REAL(mtimes)[i] = NA_REAL;
+            continue;
         }
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0 && length>0) {
-                if (nChar>length) nChar=length;
-                XXH_errorcode const updateResult = XXH64_update(state, buf, nChar);
-                if (updateResult == XXH_ERROR) {
-                    error("Error in `XXH64_update()`"); 		/* #nocov */
-                }
-                length -= nChar;
-            }
-        } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0) {
-                XXH_errorcode const updateResult = XXH64_update(state, buf, nChar);
-                if (updateResult == XXH_ERROR) {
-                    error("Error in `XXH64_update()`"); 		/* #nocov */
-                }
-            }
-        }
-        XXH64_hash_t val =  XXH64_digest(state);
-        XXH64_freeState(state);
+        snprintf(key, sizeof(key), "%" PRIx64 ":%" PRIx64 ":%" PRId64 ":%" PRId64 ".%09" PRId64
+                 ":%" PRId64 ".%09" PRId64, st.dev, st.ino, st.size, st.mtime_sec,
+                 st.mtime_nsec, st.ctime_sec, st.ctime_nsec);
+        SET_STRING_ELT(keys, i, mkChar(key));
+        INTEGER(modes)[i] = (int) st.mode;
+        REAL(mtimes)[i] = (double) st.mtime_sec + 1e-9 * (double) st.mtime_nsec;
+    }
+
+    SEXP ans = PROTECT(allocVector(VECSXP, 3));
+    SEXP names = PROTECT(allocVector(STRSXP, 3));
+    SET_VECTOR_ELT(ans, 0, keys);
+    SET_VECTOR_ELT(ans, 1, modes);
+    SET_VECTOR_ELT(ans, 2, mtimes);
+    SET_STRING_ELT(names, 0, mkChar("key"));
+    SET_STRING_ELT(names, 1, mkChar("mode"));
+    SET_STRING_ELT(names, 2, mkChar("mtime"));
+    setAttrib(ans, R_NamesSymbol, names);
+    UNPROTECT(5);
+    return ans;
+}
 
-        _store_from_int64(val, output, leaveRaw);
-        break;
-    }
-    case 108: {     /* murmur32 */
-        unsigned int h1=seed, carry=0;
-        unsigned char buf[BUF_SIZE];
-        size_t total_length = 0;
-        output_length = 4;
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
-
-        if (length>=0) {
-            while( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0
-                   && length>0) {
-                if (nChar>length) nChar=length;
-                PMurHash32_Process(&h1, &carry, buf, nChar);
-                length -= nChar;
-                total_length += nChar;
-            }
-        } else {
-            while( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0) {
-                PMurHash32_Process(&h1, &carry, buf, nChar);
-                total_length += nChar;
-            }
+// splits a raw vector or a file at content-defined boundaries and hashes
+// each chunk; returns list(offset, length, digest)
+SEXP digest_chunks(SEXP Object, SEXP File, SEXP Algo, SEXP Min, SEXP Avg, SEXP Max,
+                   SEXP Seed, SEXP Chunk_size, SEXP Output) {
+    int output = INTEGER_VALUE(Output);
+    int64_t chunk = _as_count(Chunk_size);  /* 0 or NA for the default */
+    cdc_digest d;
+
+    int output_length = cdc_digest_init(&d, INTEGER_VALUE(Algo), (uint32_t) INTEGER_VALUE(Seed),
+                                        (uint64_t) _as_count(Min), (uint64_t) _as_count(Avg),
+                                        (uint64_t) _as_count(Max));
+    if (output_length < 0)
+        error("Unsupported algorithm code or chunk sizes"); /* should not be reached due to test in R */ /* #nocov */
+
+    if (asLogical(File)) {
+        if (TYPEOF(Object) != STRSXP || XLENGTH(Object) != 1 || STRING_ELT(Object, 0) == NA_STRING)
+            error("File must be given as a single file name");  /* #nocov */
+        _digest_file_options();
+        int status = file_reader_run(CHAR(STRING_ELT(Object, 0)), 0, -1,
+                                     chunk > 0 ? (size_t) chunk : 0, cdc_digest_update, &d);
+        if (status != FILE_READER_OK) {
+            cdc_digest_free(&d);
+            error(status == FILE_READER_EOPEN ? "The file could not be opened"
+                                              : "The file could not be read");
         }
-        unsigned int val = PMurHash32_Result(h1, carry, total_length);
+    } else {
+        if (TYPEOF(Object) != RAWSXP)
+            error("Object must be a raw vector");  /* #nocov */
+        cdc_digest_update(&d, RAW(Object), (size_t) XLENGTH(Object));
+    }
+    if (cdc_digest_final(&d) != 0) {
+        cdc_digest_free(&d);
+        error("Out of memory while chunking");  /* #nocov */
+    }
+
+    R_xlen_t n = (R_xlen_t) d.n;
+    SEXP offsets = PROTECT(allocVector(REALSXP, n));
+    SEXP lengths = PROTECT(allocVector(REALSXP, n));
+    SEXP digests = PROTECT(_vdigest_alloc(n, output_length, output));
+    for (R_xlen_t i = 0; i < n; i++) {
+        REAL(offsets)[i] = (double) d.offsets[i];
+        REAL(lengths)[i] = (double) d.lengths[i];
+    }
+    _vdigest_store_batch(digests, 0, d.digests, d.n, output_length, output);
+    cdc_digest_free(&d);
+
+    SEXP ans = PROTECT(allocVector(VECSXP, 3));
+    SEXP names = PROTECT(allocVector(STRSXP, 3));
+    SET_VECTOR_ELT(ans, 0, offsets);
+    SET_VECTOR_ELT(ans, 1, lengths);
+    SET_VECTOR_ELT(ans, 2, digests);
+    SET_STRING_ELT(names, 0, mkChar("offset"));
+    SET_STRING_ELT(names, 1, mkChar("length"));
+    SET_STRING_ELT(names, 2, mkChar("digest"));
+    setAttrib(ans, R_NamesSymbol, names);
+    UNPROTECT(5);
+    return ans;
+}
 
-        _store_from_int32(val, output, leaveRaw);
-        break;
-    }
-    case 110: {     /* blake3 file case */
-        output_length = BLAKE3_OUT_LEN;
-        unsigned char buf[BUF_SIZE];
-        uint8_t val[BLAKE3_OUT_LEN];
-        blake3_hasher hasher;
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
+/* windows hashed per task of rolling_hash() at least */
+#define ROLLING_TASK_WINDOWS ((size_t) 1 << 20)
 
-        blake3_hasher_init(&hasher);
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0 && length>0) {
-                if (nChar>length) nChar=length;
-                blake3_hasher_update( &hasher, buf, nChar );
-                length -= nChar;
-            }
-        } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0)
-                blake3_hasher_update( &hasher, buf, nChar );
-        }
-        blake3_hasher_finalize(&hasher, val, BLAKE3_OUT_LEN);
+typedef struct {
+    const unsigned char *buf;
+    size_t count;
+    double *out;
+} rolling_segment;
 
-        _store_from_char_ptr(val, output, output_length, leaveRaw);
-        break;
-    }
-    case 111: {		/* crc32c */
-        unsigned char buf[BUF_SIZE];
-        output_length = 4;
-        uint32_t crc = 0;
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
-
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0 && length>0) {
-                if (nChar>length) nChar=length;
-                crc = crc32c_extend(crc, (const uint8_t*) buf, (size_t) nChar);
-                length -= nChar;
-            }
-        } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0)
-                crc = crc32c_extend(crc, (const uint8_t*) buf, (size_t) nChar);
-        }
+typedef struct {
+    pool_task task;
+    const rolling_hasher *r;
+    const rolling_segment *segs;
+    size_t from, to;
+} rolling_job;
 
-        _store_from_int32(crc, output, leaveRaw);
-        break;
+static void _rolling_job_run(void *arg) {
+    rolling_job *job = (rolling_job *) arg;
+    for (size_t i = job->from; i < job->to; i++) {
+        const rolling_segment *s = job->segs + i;
+        rolling_run(job->r, s->buf, 0, s->count, s->out);
     }
-    case 112: {     /* xxh3_64 */
-        unsigned char buf[BUF_SIZE];
-        output_length = 8;
-        XXH3_state_t* const state = XXH3_createState();
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
-
-        XXH_errorcode const resetResult = XXH3_64bits_reset(state);
-        if (resetResult == XXH_ERROR) {
-            error("Error in `XXH3_reset()`"); 				/* #nocov */
-        }
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0 && length>0) {
-                if (nChar>length) nChar=length;
-                XXH_errorcode const updateResult = XXH3_64bits_update(state, buf, nChar);
-                if (updateResult == XXH_ERROR) {
-                    error("Error in `XXH3_64bits_update()`"); 		/* #nocov */
-                }
-                length -= nChar;
-            }
-        } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0) {
-                XXH_errorcode const updateResult = XXH3_64bits_update(state, buf, nChar);
-                if (updateResult == XXH_ERROR) {
-                    error("Error in `XXH3_64bit_update()`"); 		/* #nocov */
-                }
-            }
-        }
-        XXH64_hash_t val =  XXH3_64bits_digest(state);
-        XXH3_freeState(state);
+}
 
-        _store_from_int64(val, output, leaveRaw);
-        break;
-    }
-    case 113: {     /* xxh3_128 */
-        unsigned char buf[BUF_SIZE];
-        XXH3_state_t* const state = XXH3_createState();
-        output_length = 16;
-        if (skip > 0) fseek(fp, skip, SEEK_SET);
+static SEXP _rolling_alloc(R_xlen_t n, int bits) {
+    SEXP v = PROTECT(allocVector(REALSXP, n));
+    if (bits == 64) setAttrib(v, R_ClassSymbol, mkString("integer64"));
+    UNPROTECT(1);
+    return v;
+}
 
-        XXH_errorcode const resetResult = XXH3_128bits_reset(state);
-        if (resetResult == XXH_ERROR) {
-            error("Error in `XXH3_reset()`"); 				/* #nocov */
-        }
-        if (length>=0) {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0 && length>0) {
-                if (nChar>length) nChar=length;
-                XXH_errorcode const updateResult = XXH3_128bits_update(state, buf, nChar);
-                if (updateResult == XXH_ERROR) {
-                    error("Error in `XXH3_128bits_update()`"); 		/* #nocov */
-                }
-                length -= nChar;
+// hashes of all windows of Width bytes of a raw vector, or of each string
+// of a character vector, computed in one pass over the data
+SEXP rolling_hash(SEXP X, SEXP Width, SEXP Algo, SEXP Bits, SEXP Seed, SEXP Threads) {
+    int bits = INTEGER_VALUE(Bits), threads = INTEGER_VALUE(Threads);
+    int64_t width = _as_count(Width);
+    R_xlen_t n = TYPEOF(X) == RAWSXP ? 1 : XLENGTH(X);
+    rolling_hasher r;
+
+    if (TYPEOF(X) != RAWSXP && TYPEOF(X) != STRSXP)
+        error("X must be a raw or character vector");  /* #nocov */
+    if (width < 1 || rolling_init(&r, INTEGER_VALUE(Algo), bits, (size_t) width,
+                                  (uint64_t) (uint32_t) INTEGER_VALUE(Seed)) != 0)
+        error("Unsupported rolling hash or width"); /* should not be reached due to test in R */ /* #nocov */
+
+    /* every input is split into segments of about ROLLING_TASK_WINDOWS
+       windows, each starting afresh from its first full window */
+    size_t nsegs = 0;
+    for (R_xlen_t i = 0; i < n; i++) {
+        size_t len = TYPEOF(X) == RAWSXP ? (size_t) XLENGTH(X)
+            : STRING_ELT(X, i) == NA_STRING ? 0 : (size_t) LENGTH(STRING_ELT(X, i));
+        size_t count = len >= (size_t) width ? len - (size_t) width + 1 : 0;
+        nsegs += (count + ROLLING_TASK_WINDOWS - 1) / ROLLING_TASK_WINDOWS;
+    }
+    rolling_segment *segs = (rolling_segment *) R_alloc(nsegs + 1, sizeof(*segs));
+
+    SEXP ans = PROTECT(TYPEOF(X) == RAWSXP ? R_NilValue : allocVector(VECSXP, n));
+    size_t k = 0;
+    for (R_xlen_t i = 0; i < n; i++) {
+        const unsigned char *buf;
+        size_t len;
+        SEXP v;
+
+        if (TYPEOF(X) == RAWSXP) {
+            buf = RAW(X);
+            len = (size_t) XLENGTH(X);
+        } else if (STRING_ELT(X, i) == NA_STRING) {
+            v = _rolling_alloc(1, bits);
+            SET_VECTOR_ELT(ans, i, v);
+            if (bits == 64) {           /* NA of integer64 */
+                int64_t na = INT64_MIN;
+                memcpy(REAL(v), &na, sizeof(double));
+            } else {
+                REAL(v)[0] = NA_REAL;
             }
+            continue;
         } else {
-            while ( ( nChar = fread( buf, 1, sizeof( buf ), fp ) ) > 0) {
-                XXH_errorcode const updateResult = XXH3_128bits_update(state, buf, nChar);
-                if (updateResult == XXH_ERROR) {
-                    error("Error in `XXH3_128bit_update()`"); 		/* #nocov */
-                }
-            }
+            buf = (const unsigned char *) CHAR(STRING_ELT(X, i));
+            len = (size_t) LENGTH(STRING_ELT(X, i));
         }
-        XXH128_hash_t val =  XXH3_128bits_digest(state);
-        XXH3_freeState(state);
-
-        if (leaveRaw) {
-            XXH128_canonical_t canon;
-            XXH128_canonicalFromHash(&canon, val);
-            memcpy(output, &canon, 16);
+        size_t count = len >= (size_t) width ? len - (size_t) width + 1 : 0;
+        v = _rolling_alloc((R_xlen_t) count, bits);
+        if (TYPEOF(X) == RAWSXP) {
+            UNPROTECT(1);
+            ans = PROTECT(v);
         } else {
-            snprintf(output, 128, "%016" PRIx64 "%016" PRIx64, val.high64, val.low64);
+            SET_VECTOR_ELT(ans, i, v);
+        }
+        for (size_t from = 0; from < count; from += ROLLING_TASK_WINDOWS, k++) {
+            segs[k].buf = buf + from;
+            segs[k].count = count - from < ROLLING_TASK_WINDOWS ? count - from : ROLLING_TASK_WINDOWS;
+            segs[k].out = REAL(v) + from;
         }
-        break;
     }
 
-    default: {
-        error("Unsupported algorithm code"); /* should not be reached due to test in R */ /* #nocov */
+    /* short strings are grouped so that each task has enough work */
+    size_t njobs = 0, windows = 0;
+    for (size_t i = 0; i < nsegs; i++) {
+        windows += segs[i].count;
+        if (windows >= ROLLING_TASK_WINDOWS || i == nsegs - 1) {
+            njobs++;
+            windows = 0;
+        }
     }
-    } /* end switch */
-
-    if (algo >= 100 && fp) {
-        fclose(fp);
+    rolling_job *jobs = (rolling_job *) R_alloc(njobs + 1, sizeof(*jobs));
+    size_t j = 0, from = 0;
+    windows = 0;
+    for (size_t i = 0; i < nsegs; i++) {
+        windows += segs[i].count;
+        if (windows >= ROLLING_TASK_WINDOWS || i == nsegs - 1) {
+            jobs[j].task.fn = _rolling_job_run;
+            jobs[j].task.arg = &jobs[j];
+            jobs[j].r = &r;
+            jobs[j].segs = segs;
+            jobs[j].from = from;
+            jobs[j].to = from = i + 1;
+            j++;
+            windows = 0;
+        }
     }
 
-    if (leaveRaw) {
-        PROTECT(result=allocVector(RAWSXP, output_length));
-        memcpy(RAW(result), output, output_length);
+    thread_pool *pool = njobs > 1 ? thread_pool_create(threads) : NULL;
+    if (pool == NULL) {
+        for (j = 0; j < njobs; j++) _rolling_job_run(&jobs[j]);
     } else {
-        PROTECT(result=allocVector(STRSXP, 1));
-        SET_STRING_ELT(result, 0, mkChar(output));
+        for (j = 0; j < njobs; j++) thread_pool_submit(pool, &jobs[j].task);
+        for (j = 0; j < njobs; j++) thread_pool_wait(pool, &jobs[j].task);
+        thread_pool_destroy(pool);
     }
     UNPROTECT(1);
-
-    return result;
+    return ans;
 }
 
-
-SEXP vdigest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Leave_raw, SEXP Seed){
-    R_xlen_t n = length(Txt);
-    if (TYPEOF(Txt) == RAWSXP || n == 0)
-        return(digest(Txt, Algo, Length, Skip, Leave_raw, Seed));
-    SEXP ans = PROTECT(allocVector(STRSXP, n));
-    SEXP d = R_NilValue;
-    if (TYPEOF(Txt) == VECSXP){
-        for (R_xlen_t i = 0; i < n; i++){
-            d = digest(VECTOR_ELT(Txt, i), Algo, Length, Skip, Leave_raw, Seed);
-            SET_STRING_ELT(ans, i, STRING_ELT(d, 0));
-        }
+// blake3 in its keyed or key derivation mode, and with any output length:
+// a raw vector gives one digest, a list of raw vectors one per element,
+// and a character vector one per string or, with File set, per file
+SEXP blake3_modes(SEXP Object, SEXP File, SEXP Key, SEXP Context, SEXP Output_length,
+                  SEXP Output, SEXP Chunk_size, SEXP Threads) {
+    int64_t output_length = _as_count(Output_length), chunk = _as_count(Chunk_size);
+    int threads = INTEGER_VALUE(Threads), output = INTEGER_VALUE(Output);
+    digest_hasher start;
+
+    if (output_length < 1 || output_length > INT_MAX / 2)
+        error("Invalid output length");  /* #nocov */
+    if (TYPEOF(Key) == RAWSXP) {
+        if (XLENGTH(Key) != BLAKE3_KEY_LEN)
+            error("The key must be %d bytes long", BLAKE3_KEY_LEN);  /* #nocov */
+        hasher_init_blake3(&start, RAW(Key), NULL);
+    } else if (TYPEOF(Context) == STRSXP) {
+        if (XLENGTH(Context) != 1 || STRING_ELT(Context, 0) == NA_STRING)
+            error("The context must be a single string");  /* #nocov */
+        hasher_init_blake3(&start, NULL, CHAR(STRING_ELT(Context, 0)));
     } else {
-        for (R_xlen_t i = 0; i < n; i++){
-            d = digest(STRING_ELT(Txt, i), Algo, Length, Skip, Leave_raw, Seed);
-            SET_STRING_ELT(ans, i, STRING_ELT(d, 0));
-        }
-    }
-    UNPROTECT(1);
-    return ans;
+        hasher_init(&start, 10, 0);
+    }
+
+    if (TYPEOF(Object) == RAWSXP) {
+        R_xlen_t len = XLENGTH(Object);
+        unsigned char *hash = (unsigned char *) R_alloc((size_t) output_length, 1);
+        thread_pool *pool = (threads > 1 && len >= DIGEST_THREADS_MIN_LEN)
+            ? thread_pool_create(threads) : NULL;
+
+        start.pool = pool;
+        hasher_update(&start, RAW(Object), (size_t) len);
+        thread_pool_destroy(pool);
+        hasher_final_len(&start, hash, (size_t) output_length);
+        SEXP ans = PROTECT(_vdigest_alloc(1, (int) output_length, output));
+        _vdigest_store(ans, 0, hash, (int) output_length, output);
+        UNPROTECT(1);
+        return ans;
+    }
+    if (TYPEOF(Object) != STRSXP && !(TYPEOF(Object) == VECSXP && _is_raw_list(Object)))
+        error("Object must be a raw vector, a list of them or a character vector");  /* #nocov */
+    return _vdigest_batched(Object, asLogical(File) ? 110 : 10, -1, 0, 0,
+                            chunk > 0 ? (size_t) chunk : 0, threads, output, &start,
+                            (int) output_length);
 }
@@ -21,10 +21,44 @@
 
 */
 
+#include <stdint.h>
+
 #include <Rinternals.h>
 
 SEXP is_big_endian(void);
 SEXP is_little_endian(void);
 
-SEXP digest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Leave_raw, SEXP Seed);
-SEXP vdigest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Leave_raw, SEXP Seed);
+SEXP digest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Leave_raw, SEXP Seed,
+            SEXP Chunk_size, SEXP Threads);
+SEXP vdigest(SEXP Txt, SEXP Algo, SEXP Length, SEXP Skip, SEXP Output, SEXP Seed,
+             SEXP Chunk_size, SEXP Threads);
+SEXP digest_serialize(SEXP Object, SEXP Algo, SEXP Length, SEXP Skip, SEXP Ascii,
+                      SEXP Leave_raw, SEXP Seed, SEXP Version);
+SEXP digest_files(SEXP Paths, SEXP Algo, SEXP Length, SEXP Skip, SEXP Seed,
+                  SEXP Chunk_size, SEXP Threads, SEXP Io_threads, SEXP Output);
+SEXP digest_stat(SEXP Paths);
+SEXP digest_chunks(SEXP Object, SEXP File, SEXP Algo, SEXP Min, SEXP Avg, SEXP Max,
+                   SEXP Seed, SEXP Chunk_size, SEXP Output);
+SEXP rolling_hash(SEXP X, SEXP Width, SEXP Algo, SEXP Bits, SEXP Seed, SEXP Threads);
+SEXP blake3_modes(SEXP Object, SEXP File, SEXP Key, SEXP Context, SEXP Output_length,
+                  SEXP Output, SEXP Chunk_size, SEXP Threads);
+SEXP vdigest_serialize(SEXP Object, SEXP Algo, SEXP Length, SEXP Skip, SEXP Ascii,
+                       SEXP Seed, SEXP Version, SEXP Threads, SEXP Output);
+
+int64_t _as_count(SEXP x);
+void _digest_file_options(void);
+
+void _store_from_char_ptr(const unsigned char *hash, char *const output,
+                          const size_t output_length, const int leaveRaw);
+SEXP _digest_result(const unsigned char *hash, const int output_length, const int leaveRaw);
+
+/* result formats of vdigest() and vdigest_serialize() */
+#define VDIGEST_OUTPUT_HEX      0
+#define VDIGEST_OUTPUT_RAW      1
+#define VDIGEST_OUTPUT_NUMERIC  2
+
+SEXP _vdigest_alloc(const R_xlen_t n, const int output_length, const int output);
+void _vdigest_store(SEXP ans, const R_xlen_t i, const unsigned char *hash,
+                    const int output_length, const int output);
+void _vdigest_store_batch(SEXP ans, const R_xlen_t start, const unsigned char *out,
+                          const size_t n, const int output_length, const int output);
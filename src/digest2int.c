@@ -1,6 +1,10 @@
 #include <R.h>
 #include <Rdefines.h>
 #include <stdint.h>
+#include <string.h>
+
+#include "pmurhash.h"
+#include "xxhash.h"
 
 // https://en.wikipedia.org/wiki/Jenkins_hash_function#one_at_a_time
 uint32_t jenkins_one_at_a_time_hash(const char *key, uint32_t seed) {
@@ -18,20 +22,208 @@ uint32_t jenkins_one_at_a_time_hash(const char *key, uint32_t seed) {
     return hash;
 }
 
-SEXP digest2int(SEXP input, SEXP Seed) {
+// little endian reads, whatever the platform
+static uint64_t _read64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static uint64_t _read32(const unsigned char *p) {
+    return (uint64_t) p[0] | ((uint64_t) p[1] << 8) | ((uint64_t) p[2] << 16) |
+        ((uint64_t) p[3] << 24);
+}
+
+static uint64_t _rotl64(uint64_t x, int r) {
+    return (x << r) | (x >> (64 - r));
+}
+
+static uint64_t _fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
+}
+
+// the first half of MurmurHash3_x64_128 by Austin Appleby (public domain),
+// as e.g. mmh3.hash64() gives it
+static uint64_t murmur3_64(const unsigned char *p, size_t len, uint32_t seed) {
+    const uint64_t c1 = 0x87c37b91114253d5ULL, c2 = 0x4cf5ad432745937fULL;
+    uint64_t h1 = seed, h2 = seed, k1, k2;
+    size_t nblocks = len / 16;
+
+    for (size_t i = 0; i < nblocks; i++, p += 16) {
+        k1 = _read64(p);
+        k2 = _read64(p + 8);
+        k1 *= c1; k1 = _rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+        h1 = _rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+        k2 *= c2; k2 = _rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        h2 = _rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+    }
+
+    k1 = k2 = 0;
+    switch (len & 15) {
+    case 15: k2 ^= (uint64_t) p[14] << 48; /* fall through */
+    case 14: k2 ^= (uint64_t) p[13] << 40; /* fall through */
+    case 13: k2 ^= (uint64_t) p[12] << 32; /* fall through */
+    case 12: k2 ^= (uint64_t) p[11] << 24; /* fall through */
+    case 11: k2 ^= (uint64_t) p[10] << 16; /* fall through */
+    case 10: k2 ^= (uint64_t) p[9] << 8;   /* fall through */
+    case 9:  k2 ^= (uint64_t) p[8];
+        k2 *= c2; k2 = _rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+        /* fall through */
+    case 8:  k1 ^= (uint64_t) p[7] << 56;  /* fall through */
+    case 7:  k1 ^= (uint64_t) p[6] << 48;  /* fall through */
+    case 6:  k1 ^= (uint64_t) p[5] << 40;  /* fall through */
+    case 5:  k1 ^= (uint64_t) p[4] << 32;  /* fall through */
+    case 4:  k1 ^= (uint64_t) p[3] << 24;  /* fall through */
+    case 3:  k1 ^= (uint64_t) p[2] << 16;  /* fall through */
+    case 2:  k1 ^= (uint64_t) p[1] << 8;   /* fall through */
+    case 1:  k1 ^= (uint64_t) p[0];
+        k1 *= c1; k1 = _rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+    }
+
+    h1 ^= (uint64_t) len;
+    h2 ^= (uint64_t) len;
+    h1 += h2;
+    h2 += h1;
+    h1 = _fmix64(h1);
+    h2 = _fmix64(h2);
+    return h1 + h2;
+}
+
+// 64 x 64 -> 128 bit multiplication, the halves left in *a and *b
+static void _wymum(uint64_t *a, uint64_t *b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = (__uint128_t) *a * *b;
+    *a = (uint64_t) r;
+    *b = (uint64_t) (r >> 64);
+#else
+    uint64_t ha = *a >> 32, hb = *b >> 32, la = (uint32_t) *a, lb = (uint32_t) *b;
+    uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    uint64_t t = rl + (rm0 << 32), c = t < rl, lo = t + (rm1 << 32);
+    c += lo < t;
+    *a = lo;
+    *b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+}
+
+static uint64_t _wymix(uint64_t a, uint64_t b) {
+    _wymum(&a, &b);
+    return a ^ b;
+}
+
+// wyhash, final version 4, by Wang Yi (public domain), with its default secret
+static uint64_t wyhash(const unsigned char *p, size_t len, uint64_t seed) {
+    static const uint64_t secret[4] = {
+        0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL
+    };
+    uint64_t a, b;
+
+    seed ^= _wymix(seed ^ secret[0], secret[1]);
+    if (len <= 16) {
+        if (len >= 4) {
+            size_t k = (len >> 3) << 2;
+            a = (_read32(p) << 32) | _read32(p + k);
+            b = (_read32(p + len - 4) << 32) | _read32(p + len - 4 - k);
+        } else if (len > 0) {
+            a = ((uint64_t) p[0] << 16) | ((uint64_t) p[len >> 1] << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        if (i > 48) {
+            uint64_t see1 = seed, see2 = seed;
+            do {
+                seed = _wymix(_read64(p) ^ secret[1], _read64(p + 8) ^ seed);
+                see1 = _wymix(_read64(p + 16) ^ secret[2], _read64(p + 24) ^ see1);
+                see2 = _wymix(_read64(p + 32) ^ secret[3], _read64(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+        while (i > 16) {
+            seed = _wymix(_read64(p) ^ secret[1], _read64(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+        a = _read64(p + i - 16);
+        b = _read64(p + i - 8);
+    }
+    a ^= secret[1];
+    b ^= seed;
+    _wymum(&a, &b);
+    return _wymix(a ^ secret[0] ^ len, b ^ secret[1]);
+}
+
+#define DIGEST2INT_JENKINS 1
+#define DIGEST2INT_XXH3    2
+#define DIGEST2INT_MURMUR3 3
+#define DIGEST2INT_WYHASH  4
+
+static uint64_t _digest2int64(int algo, const unsigned char *p, size_t len, uint32_t seed) {
+    switch (algo) {
+    case DIGEST2INT_XXH3:    return (uint64_t) XXH3_64bits_withSeed(p, len, seed);
+    case DIGEST2INT_MURMUR3: return murmur3_64(p, len, seed);
+    default:                 return wyhash(p, len, seed);
+    }
+}
+
+// Jenkins' hash is kept as it always was, with missing strings hashed as
+// "NA"; the other algorithms give NA for them. 32-bit results of xxh3 and
+// wyhash are the low half of their 64-bit ones, murmur3 has a 32-bit
+// variant of its own. 64-bit results are stored as the bits of doubles
+// with class "integer64". Hashes are not remapped, so one that equals
+// NA_INTEGER or the integer64 NA (INT64_MIN) is returned as NA.
+SEXP digest2int(SEXP input, SEXP Seed, SEXP Algo, SEXP Bits) {
     uint32_t seed = INTEGER_VALUE(Seed);
+    int algo = INTEGER_VALUE(Algo), bits = INTEGER_VALUE(Bits);
 
     if (TYPEOF(input) != STRSXP)  error("invalid input - should be character vector");
+    if (algo < DIGEST2INT_JENKINS || algo > DIGEST2INT_WYHASH || (bits != 32 && bits != 64) ||
+        (algo == DIGEST2INT_JENKINS && bits != 32))
+        error("Unsupported algorithm or number of bits"); /* should not be reached due to test in R */ /* #nocov */
     R_xlen_t n = xlength(input);
 
+    if (bits == 64) {
+        SEXP result = PROTECT(allocVector(REALSXP, n));
+        double *res_ptr = REAL(result);
+        for (R_xlen_t i = 0; i < n; i++) {
+            SEXP s = STRING_ELT(input, i);
+            int64_t h = INT64_MIN;      /* NA of integer64 */
+            if (s != NA_STRING)
+                h = (int64_t) _digest2int64(algo, (const unsigned char *) CHAR(s),
+                                            (size_t) LENGTH(s), seed);
+            memcpy(res_ptr + i, &h, sizeof(double));
+        }
+        setAttrib(result, R_ClassSymbol, mkString("integer64"));
+        UNPROTECT(1);
+        return(result);
+    }
+
     SEXP result = PROTECT(allocVector(INTSXP, n ));
     memset(INTEGER(result), 0, n * sizeof(int));
 
     int *res_ptr = INTEGER(result);
 
     for(R_xlen_t i = 0; i < n; i++) {
-        const char* element_ptr = CHAR(STRING_ELT(input, i));
-        res_ptr[i] = jenkins_one_at_a_time_hash(element_ptr, seed);
+        SEXP s = STRING_ELT(input, i);
+        const char* element_ptr = CHAR(s);
+        if (algo == DIGEST2INT_JENKINS)
+            res_ptr[i] = jenkins_one_at_a_time_hash(element_ptr, seed);
+        else if (s == NA_STRING)
+            res_ptr[i] = NA_INTEGER;
+        else if (algo == DIGEST2INT_MURMUR3)
+            res_ptr[i] = (int) PMurHash32(seed, element_ptr, LENGTH(s));
+        else
+            res_ptr[i] = (int) (uint32_t) _digest2int64(algo, (const unsigned char *) element_ptr,
+                                                        (size_t) LENGTH(s), seed);
     }
     UNPROTECT(1);
 
@@ -0,0 +1,260 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Feed R's serializer straight into the hash functions, following the
+   approach of spooky_serialize.cpp, so that digest() no longer needs to
+   materialize the serialize() output as a raw vector first. The byte
+   stream seen by the hasher is identical to serialize(connection=NULL). */
+
+#include <string.h>
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "digest.h"
+#include "hasher.h"
+#include "hash_batch.h"
+
+typedef struct {
+    digest_hasher hasher;
+    R_xlen_t skip;              /* bytes still to be skipped */
+    int skip_lines;             /* for ascii headers: newlines still to be skipped */
+    R_xlen_t length;            /* bytes still to be hashed, or -1 for all */
+    int collect;                /* gather the bytes in buf instead of hashing them */
+    unsigned char *buf;
+    size_t buf_len, buf_size;
+} serialize_state;
+
+/* buf comes from R_alloc() and is released by the caller via vmaxset();
+   as it grows geometrically the abandoned copies add up to less than
+   its final size */
+static void _collect_bytes(serialize_state *st, const unsigned char *p, size_t n) {
+    if (st->buf_len + n > st->buf_size) {
+        size_t size = 2 * st->buf_size;
+        if (size < st->buf_len + n) size = st->buf_len + n;
+        if (size < 4096) size = 4096;
+        unsigned char *buf = (unsigned char *) R_alloc(size, 1);
+        if (st->buf_len > 0) memcpy(buf, st->buf, st->buf_len);
+        st->buf = buf;
+        st->buf_size = size;
+    }
+    memcpy(st->buf + st->buf_len, p, n);
+    st->buf_len += n;
+}
+
+static void OutBytesHasher(R_outpstream_t stream, void *buf, int length) {
+    serialize_state *st = (serialize_state *) stream->data;
+    unsigned char *p = (unsigned char *) buf;
+    R_xlen_t n = length;
+
+    while (st->skip_lines > 0 && n > 0) {
+        if (*p == '\n') st->skip_lines--;
+        p++;
+        n--;
+    }
+    if (st->skip > 0) {
+        R_xlen_t k = n < st->skip ? n : st->skip;
+        st->skip -= k;
+        p += k;
+        n -= k;
+    }
+    if (st->length >= 0) {
+        if (n > st->length) n = st->length;
+        st->length -= n;
+    }
+    if (n > 0) {
+        if (st->collect) _collect_bytes(st, p, (size_t) n);
+        else hasher_update(&st->hasher, p, (size_t) n);
+    }
+}
+
+static void OutCharHasher(R_outpstream_t stream, int c) {
+    unsigned char b = (unsigned char) c;
+    OutBytesHasher(stream, &b, 1);
+}
+
+/* skip comes in as a double like length, with NA for "auto" */
+#define SERIALIZE_SKIP_AUTO ((R_xlen_t) -2)
+
+static R_xlen_t _serialize_skip(SEXP Skip) {
+    return ISNAN(asReal(Skip)) ? SERIALIZE_SKIP_AUTO : (R_xlen_t) _as_count(Skip);
+}
+
+static R_pstream_format_t _serialize_format(SEXP Ascii) {
+    int ascii = asLogical(Ascii);
+    if (ascii == NA_LOGICAL) return R_pstream_asciihex_format;
+    return ascii ? R_pstream_ascii_format : R_pstream_xdr_format;
+}
+
+static void _serialize_state_init(serialize_state *st, R_xlen_t length, R_xlen_t skip,
+                                  R_pstream_format_t type) {
+    /* "auto" drops the serialization header, which is 14 bytes in binary
+       form, and the first four lines in ascii form */
+    st->skip_lines = 0;
+    st->skip = 0;
+    if (skip == SERIALIZE_SKIP_AUTO) {
+        if (type == R_pstream_xdr_format) st->skip = 14;
+        else st->skip_lines = 4;
+    } else if (skip > 0) {
+        st->skip = skip;
+    }
+    st->length = length;
+    st->collect = 0;
+    st->buf = NULL;
+    st->buf_len = st->buf_size = 0;
+}
+
+/* serializes object into the hasher, leaving the digest in hash; returns its length */
+static int _serialize_hash(SEXP object, int algo, R_xlen_t length, R_xlen_t skip,
+                           R_pstream_format_t type, int version, int seed,
+                           unsigned char *hash) {
+    serialize_state st;
+    struct R_outpstream_st stream;
+
+    int output_length = hasher_init(&st.hasher, algo, (uint32_t) seed);
+    if (output_length < 0)
+        error("Unsupported algorithm code"); /* should not be reached due to test in R */ /* #nocov */
+
+    _serialize_state_init(&st, length, skip, type);
+    R_InitOutPStream(&stream, (R_pstream_data_t) &st, type, version,
+                     OutCharHasher, OutBytesHasher, NULL, R_NilValue);
+    R_Serialize(object, &stream);
+
+    hasher_final(&st.hasher, hash);
+    return output_length;
+}
+
+static SEXP _serialize_digest_one(SEXP object, int algo, R_xlen_t length, R_xlen_t skip,
+                                  R_pstream_format_t type, int version, int seed,
+                                  int leaveRaw) {
+    unsigned char hash[HASHER_MAX_OUTPUT];
+    int output_length = _serialize_hash(object, algo, length, skip, type, version, seed, hash);
+    return _digest_result(hash, output_length, leaveRaw);
+}
+
+SEXP digest_serialize(SEXP Object, SEXP Algo, SEXP Length, SEXP Skip, SEXP Ascii,
+                      SEXP Leave_raw, SEXP Seed, SEXP Version) {
+    return _serialize_digest_one(Object, asInteger(Algo), (R_xlen_t) _as_count(Length),
+                                 _serialize_skip(Skip), _serialize_format(Ascii),
+                                 asInteger(Version), asInteger(Seed),
+                                 asInteger(Leave_raw));
+}
+
+/* serialized bytes gathered per batch before they are hashed on the threads */
+#define VDIGEST_SERIALIZE_BATCH_BYTES ((size_t) 64 << 20)
+#define VDIGEST_SERIALIZE_BATCH_ITEMS ((R_xlen_t) 1 << 16)
+
+/* R's serializer may only run on this thread, so with several threads the
+   elements of each batch are serialized into memory first; the hashing of
+   the batch is then spread over a pool living only for that step */
+static SEXP _vdigest_serialize_threads(SEXP Object, int algo, R_xlen_t length, R_xlen_t skip,
+                                       R_pstream_format_t type, int version, int seed,
+                                       int threads, int output) {
+    R_xlen_t n = xlength(Object);
+    R_xlen_t batch = n < VDIGEST_SERIALIZE_BATCH_ITEMS ? n : VDIGEST_SERIALIZE_BATCH_ITEMS;
+    digest_hasher probe;
+    hash_batch b;
+
+    b.output_length = hasher_init(&probe, algo, (uint32_t) seed);
+    if (b.output_length < 0)
+        error("Unsupported algorithm code"); /* should not be reached due to test in R */ /* #nocov */
+    b.algo = algo;
+    b.seed = (uint32_t) seed;
+    b.skip = 0;
+    b.length = -1;
+    b.io_threads = 0;
+    b.start = NULL;
+    b.chunk_size = 0;
+    b.status = NULL;
+    b.msgs = (const unsigned char **) R_alloc(batch, sizeof(*b.msgs));
+    size_t *lens = (size_t *) R_alloc(batch, sizeof(*lens));
+    b.lens = lens;
+    b.out = (unsigned char *) R_alloc(batch, b.output_length);
+
+    SEXP ans = PROTECT(_vdigest_alloc(n, b.output_length, output));
+    for (R_xlen_t start = 0; start < n; start += (R_xlen_t) b.n) {
+        const void *vmax = vmaxget();
+        size_t bytes = 0;
+
+        for (b.n = 0; (R_xlen_t) b.n < batch && start + (R_xlen_t) b.n < n &&
+                 bytes < VDIGEST_SERIALIZE_BATCH_BYTES; b.n++) {
+            serialize_state st;
+            struct R_outpstream_st stream;
+
+            _serialize_state_init(&st, length, skip, type);
+            st.collect = 1;
+            R_InitOutPStream(&stream, (R_pstream_data_t) &st, type, version,
+                             OutCharHasher, OutBytesHasher, NULL, R_NilValue);
+            R_Serialize(VECTOR_ELT(Object, start + (R_xlen_t) b.n), &stream);
+            b.msgs[b.n] = st.buf;
+            lens[b.n] = st.buf_len;
+            bytes += st.buf_len;
+        }
+
+        thread_pool *pool = b.n > 1 ? thread_pool_create(threads) : NULL;
+        hash_batch_run(&b, pool);
+        thread_pool_destroy(pool);
+
+        _vdigest_store_batch(ans, start, b.out, b.n, b.output_length, output);
+        vmaxset(vmax);
+    }
+    UNPROTECT(1);
+    return ans;
+}
+
+/* vectorised variant: each list element is serialized and hashed on its
+   own, matching lapply(object, serialize) in the former R code */
+SEXP vdigest_serialize(SEXP Object, SEXP Algo, SEXP Length, SEXP Skip, SEXP Ascii,
+                       SEXP Seed, SEXP Version, SEXP Threads, SEXP Output) {
+    R_xlen_t n = xlength(Object);
+    int algo = asInteger(Algo);
+    R_xlen_t length = (R_xlen_t) _as_count(Length), skip = _serialize_skip(Skip);
+    int version = asInteger(Version), seed = asInteger(Seed), threads = asInteger(Threads);
+    int output = asInteger(Output);
+    R_pstream_format_t type = _serialize_format(Ascii);
+    unsigned char hash[HASHER_MAX_OUTPUT];
+    digest_hasher probe;
+
+    int output_length = hasher_init(&probe, algo, (uint32_t) seed);
+    if (output_length < 0)
+        error("Unsupported algorithm code"); /* should not be reached due to test in R */ /* #nocov */
+
+    if (n == 0 || TYPEOF(Object) != VECSXP) {
+        SEXP ans = PROTECT(_vdigest_alloc(1, output_length, output));
+        _serialize_hash(Object, algo, length, skip, type, version, seed, hash);
+        _vdigest_store(ans, 0, hash, output_length, output);
+        UNPROTECT(1);
+        return ans;
+    }
+    if (threads > 1 && n > 1)
+        return _vdigest_serialize_threads(Object, algo, length, skip, type, version,
+                                          seed, threads, output);
+
+    SEXP ans = PROTECT(_vdigest_alloc(n, output_length, output));
+    for (R_xlen_t i = 0; i < n; i++) {
+        _serialize_hash(VECTOR_ELT(Object, i), algo, length, skip, type, version, seed, hash);
+        _vdigest_store(ans, i, hash, output_length, output);
+    }
+    UNPROTECT(1);
+    return ans;
+}
@@ -0,0 +1,326 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "file_reader.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+static int _file_reader_use_mmap = 0;
+
+void file_reader_set_mmap(int on) {
+    _file_reader_use_mmap = on;
+}
+
+#ifdef _WIN32
+
+/* no mmap here: a large unbuffered fread() loop on the wide-char path */
+int file_reader_run(const char *path, int64_t skip, int64_t length,
+                    size_t chunk_size, file_chunk_fn fn, void *data) {
+    FILE *fp;
+    wchar_t *wpath;
+    unsigned char *buf;
+    size_t n;
+    int len = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+
+    if (len <= 0) return FILE_READER_EOPEN;
+    wpath = (wchar_t *) malloc(len * sizeof(wchar_t));
+    if (wpath == NULL) return FILE_READER_EOPEN;
+    MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, len);
+    fp = _wfopen(wpath, L"rb");
+    free(wpath);
+    if (!fp) return FILE_READER_EOPEN;
+
+    if (chunk_size == 0) chunk_size = FILE_READER_CHUNK_SIZE;
+    buf = (unsigned char *) malloc(chunk_size);
+    if (buf == NULL) {
+        fclose(fp);
+        return FILE_READER_EREAD;
+    }
+    setvbuf(fp, NULL, _IONBF, 0);
+    if (skip > 0) _fseeki64(fp, skip, SEEK_SET);
+
+    while (length != 0 && (n = fread(buf, 1, chunk_size, fp)) > 0) {
+        if (length > 0 && (int64_t) n > length) n = (size_t) length;
+        fn(data, buf, n);
+        if (length > 0) length -= n;
+    }
+    int status = ferror(fp) ? FILE_READER_EREAD : FILE_READER_OK;
+    free(buf);
+    fclose(fp);
+    return status;
+}
+
+int file_reader_stat(const char *path, file_reader_stat_t *st) {
+    struct _stat64 sb;
+    wchar_t *wpath;
+    int len = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0), res;
+
+    if (len <= 0) return FILE_READER_EOPEN;
+    wpath = (wchar_t *) malloc(len * sizeof(wchar_t));
+    if (wpath == NULL) return FILE_READER_EOPEN;
+    MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, len);
+    res = _wstat64(wpath, &sb);
+    free(wpath);
+    if (res != 0) return FILE_READER_EOPEN;
+
+    st->dev = (uint64_t) sb.st_dev;
+    st->ino = 0;
+    st->size = (int64_t) sb.st_size;
+    st->mtime_sec = (int64_t) sb.st_mtime;
+    st->ctime_sec = (int64_t) sb.st_ctime;
+    st->mtime_nsec = st->ctime_nsec = 0;
+    st->mode = (unsigned int) sb.st_mode;
+    return FILE_READER_OK;
+}
+
+/* the wide-char form of a UTF-8 path, to be freed; NULL on failure */
+static wchar_t *_file_writer_wpath(const char *path) {
+    wchar_t *wpath;
+    int len = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0);
+
+    if (len <= 0) return NULL;
+    wpath = (wchar_t *) malloc(len * sizeof(wchar_t));
+    if (wpath != NULL) MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, len);
+    return wpath;
+}
+
+/* no mkstemp() here: names are tried until one can be created exclusively */
+FILE *file_writer_open_temp(const char *path, char *tmp, size_t tmp_size) {
+    unsigned long salt = (unsigned long) GetCurrentProcessId() ^ (unsigned long) GetTickCount();
+
+    for (int i = 0; i < 100; i++) {
+        wchar_t *wtmp;
+        int fd;
+        FILE *fp;
+
+        if (snprintf(tmp, tmp_size, "%s.%08lx%02x", path, salt, i) >= (int) tmp_size)
+            return NULL;
+        if ((wtmp = _file_writer_wpath(tmp)) == NULL) return NULL;
+        fd = _wopen(wtmp, _O_WRONLY | _O_CREAT | _O_EXCL | _O_BINARY, _S_IREAD | _S_IWRITE);
+        free(wtmp);
+        if (fd < 0) {
+            if (errno == EEXIST) continue;
+            return NULL;
+        }
+        fp = _fdopen(fd, "wb");
+        if (fp == NULL) {
+            _close(fd);
+            file_writer_remove(tmp);
+        }
+        return fp;
+    }
+    return NULL;
+}
+
+int file_writer_commit(const char *tmp, const char *path) {
+    wchar_t *wtmp = _file_writer_wpath(tmp), *wpath = _file_writer_wpath(path);
+    int res = -1;
+
+    if (wtmp != NULL && wpath != NULL)
+        res = MoveFileExW(wtmp, wpath, MOVEFILE_REPLACE_EXISTING) ? 0 : -1;
+    free(wtmp);
+    free(wpath);
+    return res;
+}
+
+int file_writer_remove(const char *path) {
+    wchar_t *wpath;
+    int len = MultiByteToWideChar(CP_UTF8, 0, path, -1, NULL, 0), res;
+
+    if (len <= 0) return -1;
+    wpath = (wchar_t *) malloc(len * sizeof(wchar_t));
+    if (wpath == NULL) return -1;
+    MultiByteToWideChar(CP_UTF8, 0, path, -1, wpath, len);
+    res = _wremove(wpath);
+    free(wpath);
+    return res;
+}
+
+#else
+
+/* maps [offset, offset + len) in windows of chunk_size; returns -1 if the
+   very first mapping fails so that the caller can fall back to read() */
+static int _file_reader_mmap(int fd, int64_t offset, int64_t len, size_t chunk_size,
+                             file_chunk_fn fn, void *data) {
+    int64_t page = (int64_t) sysconf(_SC_PAGESIZE);
+    int first = 1;
+
+    if (page <= 0) page = 4096;
+    if (chunk_size < (size_t) page) chunk_size = (size_t) page;
+    while (len > 0) {
+        int64_t map_off = offset - offset % page;
+        size_t delta = (size_t) (offset - map_off);
+        size_t n = len < (int64_t) chunk_size ? (size_t) len : chunk_size;
+        void *p = mmap(NULL, n + delta, PROT_READ, MAP_PRIVATE, fd, (off_t) map_off);
+        if (p == MAP_FAILED) return first ? -1 : FILE_READER_EREAD;
+#ifdef MADV_SEQUENTIAL
+        madvise(p, n + delta, MADV_SEQUENTIAL);
+#endif
+        fn(data, (const unsigned char *) p + delta, n);
+        munmap(p, n + delta);
+        offset += n;
+        len -= n;
+        first = 0;
+    }
+    return FILE_READER_OK;
+}
+
+static int _file_reader_read(int fd, int64_t skip, int64_t length, size_t chunk_size,
+                             file_chunk_fn fn, void *data) {
+    unsigned char *buf = (unsigned char *) malloc(chunk_size);
+    int status = FILE_READER_OK;
+    ssize_t n;
+
+    if (buf == NULL) return FILE_READER_EREAD;
+#if defined(POSIX_FADV_SEQUENTIAL)
+    posix_fadvise(fd, (off_t) (skip > 0 ? skip : 0),
+                  (off_t) (length > 0 ? length : 0), POSIX_FADV_SEQUENTIAL);
+#endif
+    /* pipes and other unseekable files have the skipped bytes read instead */
+    if (skip > 0 && lseek(fd, (off_t) skip, SEEK_SET) < 0) {
+        while (skip > 0) {
+            size_t want = skip < (int64_t) chunk_size ? (size_t) skip : chunk_size;
+            n = read(fd, buf, want);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+            skip -= n;
+        }
+    }
+    while (length != 0) {
+        size_t want = (length > 0 && length < (int64_t) chunk_size) ? (size_t) length : chunk_size;
+        n = read(fd, buf, want);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) status = FILE_READER_EREAD;
+        if (n <= 0) break;
+        fn(data, buf, (size_t) n);
+        if (length > 0) length -= n;
+    }
+    free(buf);
+    return status;
+}
+
+int file_reader_run(const char *path, int64_t skip, int64_t length,
+                    size_t chunk_size, file_chunk_fn fn, void *data) {
+    struct stat sb;
+    int status = -1;
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) return FILE_READER_EOPEN;
+    if (chunk_size == 0) chunk_size = FILE_READER_CHUNK_SIZE;
+    if (skip < 0) skip = 0;
+
+    /* st_size is not meaningful for pipes, devices or files under /proc */
+    if (_file_reader_use_mmap && fstat(fd, &sb) == 0 && S_ISREG(sb.st_mode) && sb.st_size > 0) {
+        int64_t avail = (int64_t) sb.st_size - skip;
+        if (avail < 0) avail = 0;
+        if (length >= 0 && length < avail) avail = length;
+        status = avail > 0
+            ? _file_reader_mmap(fd, skip, avail, chunk_size, fn, data)
+            : FILE_READER_OK;
+    }
+    if (status < 0)
+        status = _file_reader_read(fd, skip, length, chunk_size, fn, data);
+
+    close(fd);
+    return status;
+}
+
+int file_reader_stat(const char *path, file_reader_stat_t *st) {
+    struct stat sb;
+
+    if (stat(path, &sb) != 0) return FILE_READER_EOPEN;
+    st->dev = (uint64_t) sb.st_dev;
+    st->ino = (uint64_t) sb.st_ino;
+    st->size = (int64_t) sb.st_size;
+    st->mtime_sec = (int64_t) sb.st_mtime;
+    st->ctime_sec = (int64_t) sb.st_ctime;
+#if defined(__APPLE__)
+    st->mtime_nsec = (int64_t) sb.st_mtimespec.tv_nsec;
+    st->ctime_nsec = (int64_t) sb.st_ctimespec.tv_nsec;
+#elif defined(__linux__) || defined(__FreeBSD__) || defined(__NetBSD__) || \
+      defined(__OpenBSD__) || defined(__sun)
+    st->mtime_nsec = (int64_t) sb.st_mtim.tv_nsec;
+    st->ctime_nsec = (int64_t) sb.st_ctim.tv_nsec;
+#else
+    st->mtime_nsec = st->ctime_nsec = 0;
+#endif
+    st->mode = (unsigned int) sb.st_mode;
+    return FILE_READER_OK;
+}
+
+/* no mkstemp() here, as it creates the file for its owner only: names are
+   tried until one can be created exclusively, with the mode a new file
+   gets from the umask, or the mode of the file to be replaced */
+FILE *file_writer_open_temp(const char *path, char *tmp, size_t tmp_size) {
+    unsigned long salt = (unsigned long) getpid() ^ (unsigned long) time(NULL);
+    struct stat sb;
+
+    for (int i = 0; i < 100; i++) {
+        int fd;
+        FILE *fp;
+
+        if (snprintf(tmp, tmp_size, "%s.%08lx%02x", path, salt, i) >= (int) tmp_size)
+            return NULL;
+        fd = open(tmp, O_WRONLY | O_CREAT | O_EXCL, 0666);
+        if (fd < 0) {
+            if (errno == EEXIST) continue;
+            return NULL;
+        }
+        if (stat(path, &sb) == 0) fchmod(fd, sb.st_mode & 07777);
+        fp = fdopen(fd, "wb");
+        if (fp == NULL) {
+            close(fd);
+            remove(tmp);
+        }
+        return fp;
+    }
+    return NULL;
+}
+
+int file_writer_commit(const char *tmp, const char *path) {
+    return rename(tmp, path);
+}
+
+int file_writer_remove(const char *path) {
+    return remove(path);
+}
+
+#endif
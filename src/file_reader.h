@@ -0,0 +1,81 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _FILE_READER_H
+#define _FILE_READER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/* default number of bytes mapped or read per step */
+#define FILE_READER_CHUNK_SIZE ((size_t) 4 << 20)
+
+#define FILE_READER_OK     0
+#define FILE_READER_EOPEN  1    /* file could not be opened */
+#define FILE_READER_EREAD  2    /* error while reading */
+
+/* called once per chunk, in file order */
+typedef void (*file_chunk_fn)(void *data, const unsigned char *buf, size_t len);
+
+/* Feeds 'length' bytes (or all for length < 0) starting at offset 'skip'
+   of the file at 'path' (UTF-8 on Windows) to 'fn'. Files are read through
+   a large buffer, or memory mapped where possible if asked for below. No R
+   API is used, so this may be called from any thread. */
+int file_reader_run(const char *path, int64_t skip, int64_t length,
+                    size_t chunk_size, file_chunk_fn fn, void *data);
+
+/* Regular files are only memory mapped when this is on (off by default):
+   a mapped file that is truncated while it is hashed raises SIGBUS rather
+   than a read error. Not to be changed while files are being read. */
+void file_reader_set_mmap(int on);
+
+/* what identifies the version of a file for caching its digest: a file
+   whose fields are all unchanged is taken to have the same content */
+typedef struct {
+    uint64_t dev, ino;          /* ino is 0 on Windows */
+    int64_t size;
+    int64_t mtime_sec, mtime_nsec;
+    int64_t ctime_sec, ctime_nsec;  /* nanoseconds are 0 where not available */
+    unsigned int mode;          /* type and permission bits as in st_mode */
+} file_reader_stat_t;
+
+/* stat()s path, following symbolic links; returns FILE_READER_OK or
+   FILE_READER_EOPEN. No R API is used. */
+int file_reader_stat(const char *path, file_reader_stat_t *st);
+
+/* creates a new file next to path (UTF-8 on Windows) and opens it for
+   writing in binary mode, leaving its name in tmp, of tmp_size bytes;
+   NULL if none can be created. Once complete, the file is moved over path
+   by file_writer_commit(), so that path is never left half written, or
+   dropped by file_writer_remove(). A symbolic link at path is replaced,
+   not followed. No R API is used. */
+FILE *file_writer_open_temp(const char *path, char *tmp, size_t tmp_size);
+
+/* replaces path by the file tmp; 0 on success */
+int file_writer_commit(const char *tmp, const char *path);
+
+/* removes the file at path, e.g. an incomplete output; 0 on success */
+int file_writer_remove(const char *path);
+
+#endif /* _FILE_READER_H */
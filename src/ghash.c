@@ -0,0 +1,115 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* GHASH, the universal hash of GCM (NIST SP 800-38D), by Shoup's method
+   with 4-bit tables as in the common portable implementations; when the
+   CPU has PCLMULQDQ the kernels of ghash_pclmul.c are used instead. */
+
+#include <string.h>
+
+#include "ghash.h"
+
+static uint64_t _load_be64(const unsigned char *p) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; i++)
+        v = (v << 8) | p[i];
+    return v;
+}
+
+static void _store_be64(unsigned char *p, uint64_t v) {
+    for (int i = 7; i >= 0; i--, v >>= 8)
+        p[i] = (unsigned char) v;
+}
+
+void ghash_init(ghash_key *key, const unsigned char h[16]) {
+    uint64_t vh = _load_be64(h), vl = _load_be64(h + 8);
+
+    memset(key, 0, sizeof(*key));
+    /* the multiples of H by the 4-bit values, whose bits are reversed in
+       the GCM representation: entry 8 is H itself, 4 is H * x, and so on */
+    key->hl[8] = vl;
+    key->hh[8] = vh;
+    for (int i = 4; i > 0; i >>= 1) {
+        uint64_t t = (vl & 1) * 0xe1000000U;
+        vl = (vh << 63) | (vl >> 1);
+        vh = (vh >> 1) ^ (t << 32);
+        key->hl[i] = vl;
+        key->hh[i] = vh;
+    }
+    for (int i = 2; i <= 8; i *= 2)
+        for (int j = 1; j < i; j++) {
+            key->hh[i + j] = key->hh[i] ^ key->hh[j];
+            key->hl[i + j] = key->hl[i] ^ key->hl[j];
+        }
+#if DIGEST_X86_SIMD
+    if (ghash_pclmul_available()) {
+        key->pclmul = 1;
+        ghash_pclmul_init(key->hpow, h);
+    }
+#endif
+}
+
+/* the reduction of the four bits shifted out of the low end */
+static const uint64_t last4[16] = {
+    0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+    0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0
+};
+
+/* x = x * H, one nibble at a time from the end */
+static void _ghash_mult(const ghash_key *key, unsigned char x[16]) {
+    int lo = x[15] & 0xf, hi, rem;
+    uint64_t zh = key->hh[lo], zl = key->hl[lo];
+
+    for (int i = 15; i >= 0; i--) {
+        lo = x[i] & 0xf;
+        hi = x[i] >> 4;
+        if (i != 15) {
+            rem = (int) (zl & 0xf);
+            zl = (zh << 60) | (zl >> 4);
+            zh = (zh >> 4) ^ (last4[rem] << 48);
+            zh ^= key->hh[lo];
+            zl ^= key->hl[lo];
+        }
+        rem = (int) (zl & 0xf);
+        zl = (zh << 60) | (zl >> 4);
+        zh = (zh >> 4) ^ (last4[rem] << 48);
+        zh ^= key->hh[hi];
+        zl ^= key->hl[hi];
+    }
+    _store_be64(x, zh);
+    _store_be64(x + 8, zl);
+}
+
+void ghash_update(const ghash_key *key, unsigned char y[16], const unsigned char *data,
+                  size_t nblocks) {
+#if DIGEST_X86_SIMD
+    if (key->pclmul) {
+        ghash_pclmul_update(key->hpow, y, data, nblocks);
+        return;
+    }
+#endif
+    for (; nblocks > 0; nblocks--, data += 16) {
+        for (int j = 0; j < 16; j++) y[j] ^= data[j];
+        _ghash_mult(key, y);
+    }
+}
@@ -0,0 +1,57 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _GHASH_H
+#define _GHASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu_features.h"
+
+/* The hash key of GCM, with the tables for multiplying by it in
+   GF(2^128): 4-bit tables for the portable code, or the first powers of
+   the key for the carry-less multiplication */
+typedef struct {
+    uint64_t hl[16], hh[16];
+    unsigned char hpow[4][16];
+    int pclmul;
+} ghash_key;
+
+void ghash_init(ghash_key *key, const unsigned char h[16]);
+
+/* y = (y ^ block) * H for each of the nblocks 16-byte blocks of data */
+void ghash_update(const ghash_key *key, unsigned char y[16], const unsigned char *data,
+                  size_t nblocks);
+
+/* non-zero if the CPU has PCLMULQDQ, in which case the functions below
+   may be used; they exist only when DIGEST_X86_SIMD is set */
+int ghash_pclmul_available(void);
+
+#if DIGEST_X86_SIMD
+void ghash_pclmul_init(unsigned char hpow[4][16], const unsigned char h[16]);
+void ghash_pclmul_update(const unsigned char hpow[4][16], unsigned char y[16],
+                         const unsigned char *data, size_t nblocks);
+#endif
+
+#endif /* _GHASH_H */
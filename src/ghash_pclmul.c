@@ -0,0 +1,149 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* GHASH by carry-less multiplication, after Gueron and Kounavis, "Intel
+   Carry-Less Multiplication Instruction and its Usage for Computing the
+   GCM Mode" (Intel, 2010): the blocks are byte-reversed, multiplied into a
+   256-bit product and reduced modulo the bit-reflected GCM polynomial.
+   Four blocks are multiplied by the powers H^4 .. H and their products
+   summed before a single reduction. In a file of its own so that the
+   instructions can be enabled for it alone; ghash.c only calls it after
+   checking the CPU. */
+
+#include <stddef.h>
+
+#include "ghash.h"
+
+#if DIGEST_X86_SIMD
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("pclmul,ssse3"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("pclmul,ssse3")
+#endif
+
+static __m128i _reverse(__m128i x) {
+    const __m128i mask = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    return _mm_shuffle_epi8(x, mask);
+}
+
+/* adds the 256-bit product a * b to *lo, *hi */
+static void _clmul(__m128i a, __m128i b, __m128i *lo, __m128i *hi) {
+    __m128i l = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i m = _mm_xor_si128(_mm_clmulepi64_si128(a, b, 0x10),
+                              _mm_clmulepi64_si128(a, b, 0x01));
+    __m128i h = _mm_clmulepi64_si128(a, b, 0x11);
+    *lo = _mm_xor_si128(*lo, _mm_xor_si128(l, _mm_slli_si128(m, 8)));
+    *hi = _mm_xor_si128(*hi, _mm_xor_si128(h, _mm_srli_si128(m, 8)));
+}
+
+/* shifts the product left by one bit, as the operands are bit-reflected,
+   and reduces it modulo x^128 + x^7 + x^2 + x + 1 */
+static __m128i _reduce(__m128i lo, __m128i hi) {
+    __m128i t7, t8, t9, t2;
+
+    t7 = _mm_srli_epi32(lo, 31);
+    t8 = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    lo = _mm_or_si128(lo, t7);
+    hi = _mm_or_si128(_mm_or_si128(hi, t8), t9);
+
+    t7 = _mm_xor_si128(_mm_xor_si128(_mm_slli_epi32(lo, 31), _mm_slli_epi32(lo, 30)),
+                       _mm_slli_epi32(lo, 25));
+    t8 = _mm_srli_si128(t7, 4);
+    lo = _mm_xor_si128(lo, _mm_slli_si128(t7, 12));
+    t2 = _mm_xor_si128(_mm_xor_si128(_mm_srli_epi32(lo, 1), _mm_srli_epi32(lo, 2)),
+                       _mm_srli_epi32(lo, 7));
+    t2 = _mm_xor_si128(t2, t8);
+    return _mm_xor_si128(hi, _mm_xor_si128(lo, t2));
+}
+
+static __m128i _gfmul(__m128i a, __m128i b) {
+    __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+    _clmul(a, b, &lo, &hi);
+    return _reduce(lo, hi);
+}
+
+void ghash_pclmul_init(unsigned char hpow[4][16], const unsigned char h[16]) {
+    __m128i h1 = _reverse(_mm_loadu_si128((const __m128i *) h)), p = h1;
+
+    for (int i = 0; i < 4; i++) {
+        _mm_storeu_si128((__m128i *) hpow[i], p);
+        p = _gfmul(p, h1);
+    }
+}
+
+void ghash_pclmul_update(const unsigned char hpow[4][16], unsigned char y[16],
+                         const unsigned char *data, size_t nblocks) {
+    const __m128i h1 = _mm_loadu_si128((const __m128i *) hpow[0]);
+    const __m128i h2 = _mm_loadu_si128((const __m128i *) hpow[1]);
+    const __m128i h3 = _mm_loadu_si128((const __m128i *) hpow[2]);
+    const __m128i h4 = _mm_loadu_si128((const __m128i *) hpow[3]);
+    __m128i x = _reverse(_mm_loadu_si128((const __m128i *) y));
+
+    for (; nblocks >= 4; nblocks -= 4, data += 64) {
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        __m128i b0 = _reverse(_mm_loadu_si128((const __m128i *) data));
+        __m128i b1 = _reverse(_mm_loadu_si128((const __m128i *) (data + 16)));
+        __m128i b2 = _reverse(_mm_loadu_si128((const __m128i *) (data + 32)));
+        __m128i b3 = _reverse(_mm_loadu_si128((const __m128i *) (data + 48)));
+        _clmul(_mm_xor_si128(x, b0), h4, &lo, &hi);
+        _clmul(b1, h3, &lo, &hi);
+        _clmul(b2, h2, &lo, &hi);
+        _clmul(b3, h1, &lo, &hi);
+        x = _reduce(lo, hi);
+    }
+    for (; nblocks > 0; nblocks--, data += 16)
+        x = _gfmul(_mm_xor_si128(x, _reverse(_mm_loadu_si128((const __m128i *) data))), h1);
+    _mm_storeu_si128((__m128i *) y, _reverse(x));
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+int ghash_pclmul_available(void) {
+    const int need = CPU_X86_PCLMUL | CPU_X86_SSSE3;
+    return (cpu_x86_features() & need) == need;
+}
+
+#else
+
+int ghash_pclmul_available(void) {
+    return 0;
+}
+
+#endif
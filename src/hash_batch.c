@@ -0,0 +1,117 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash_batch.h"
+#include "hasher.h"
+#include "multibuf.h"
+#include "file_reader.h"
+
+/* a chunk of messages ends after this many of them or this many bytes */
+#define HASH_BATCH_CHUNK_ITEMS 1024
+#define HASH_BATCH_CHUNK_BYTES ((size_t) 256 * 1024)
+
+typedef struct {
+    pool_task task;
+    const hash_batch *batch;
+    pool_gate *gate;
+    size_t from, to;
+} hash_batch_job;
+
+static void _hash_batch_init(const hash_batch *b, digest_hasher *hasher) {
+    if (b->start != NULL) memcpy(hasher, b->start, sizeof(*hasher));
+    else hasher_init(hasher, b->algo >= 100 ? b->algo - 100 : b->algo, b->seed);
+}
+
+static void _hash_batch_range(const hash_batch *b, pool_gate *gate, const size_t from,
+                              const size_t to) {
+    digest_hasher hasher;
+
+    if (b->algo >= 100) {
+        for (size_t i = from; i < to; i++) {
+            _hash_batch_init(b, &hasher);
+            pool_gate_enter(gate);
+            b->status[i] = file_reader_run((const char *) b->msgs[i], b->skip, b->length,
+                                           b->chunk_size, hasher_update_chunk, &hasher);
+            pool_gate_leave(gate);
+            hasher_final_len(&hasher, b->out + i * b->output_length, b->output_length);
+        }
+    } else if (b->start == NULL && multibuf_lanes(b->algo) > 0) {
+        multibuf_digest(b->algo, to - from, b->msgs + from, b->lens + from,
+                        b->out + from * b->output_length);
+    } else {
+        for (size_t i = from; i < to; i++) {
+            _hash_batch_init(b, &hasher);
+            hasher_update(&hasher, b->msgs[i], b->lens[i]);
+            hasher_final_len(&hasher, b->out + i * b->output_length, b->output_length);
+        }
+    }
+}
+
+static void _hash_batch_job_run(void *arg) {
+    hash_batch_job *job = (hash_batch_job *) arg;
+    _hash_batch_range(job->batch, job->gate, job->from, job->to);
+}
+
+/* end of the chunk starting at from: files are costly enough to go one by one */
+static size_t _hash_batch_chunk_end(const hash_batch *b, size_t from) {
+    size_t bytes = 0, i = from;
+
+    if (b->algo >= 100) return from + 1;
+    while (i < b->n && i - from < HASH_BATCH_CHUNK_ITEMS && bytes < HASH_BATCH_CHUNK_BYTES)
+        bytes += b->lens[i++];
+    return i;
+}
+
+void hash_batch_run(const hash_batch *b, thread_pool *pool) {
+    hash_batch_job *jobs;
+    size_t njobs = 0;
+
+    if (pool != NULL) {
+        for (size_t i = 0; i < b->n; i = _hash_batch_chunk_end(b, i)) njobs++;
+    }
+    if (njobs < 2 || (jobs = (hash_batch_job *) malloc(njobs * sizeof(*jobs))) == NULL) {
+        _hash_batch_range(b, NULL, 0, b->n);
+        return;
+    }
+
+    pool_gate *gate = b->algo >= 100 && b->io_threads < thread_pool_size(pool)
+        ? pool_gate_create(b->io_threads) : NULL;
+    size_t j = 0;
+    for (size_t i = 0; i < b->n; j++) {
+        jobs[j].task.fn = _hash_batch_job_run;
+        jobs[j].task.arg = &jobs[j];
+        jobs[j].batch = b;
+        jobs[j].gate = gate;
+        jobs[j].from = i;
+        jobs[j].to = i = _hash_batch_chunk_end(b, i);
+        thread_pool_submit(pool, &jobs[j].task);
+    }
+    /* the calling thread takes its share of queued chunks while waiting */
+    for (j = 0; j < njobs; j++)
+        thread_pool_wait(pool, &jobs[j].task);
+    pool_gate_destroy(gate);
+    free(jobs);
+}
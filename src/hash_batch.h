@@ -0,0 +1,59 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _HASH_BATCH_H
+#define _HASH_BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "thread_pool.h"
+
+/* A batch of independent inputs hashed with the same settings, as in
+   vdigest(). Everything the hashing needs is gathered beforehand by the
+   caller, so that hash_batch_run() uses no R API and can be spread over
+   the threads of a pool; turning the digests into R objects is again up
+   to the caller. */
+typedef struct {
+    int algo;                   /* as for digest(), i.e. plus 100 for files */
+    uint32_t seed;
+    int64_t skip;               /* for files; messages come with these applied */
+    int64_t length;
+    size_t chunk_size;          /* file read size, 0 for the default */
+    size_t n;
+    const unsigned char **msgs; /* the messages, or the file names */
+    const size_t *lens;         /* message lengths, unused for files */
+    const void *start;          /* if not NULL, the digest_hasher state every input
+                                   starts from, instead of hasher_init(algo, seed) */
+    int output_length;          /* as returned by hasher_init(), or any length for blake3 */
+    unsigned char *out;         /* n digests of output_length bytes each */
+    int *status;                /* FILE_READER_* result per file, unused for messages */
+    int io_threads;             /* files read at the same time at most, 0 for no limit */
+} hash_batch;
+
+/* hashes all inputs of the batch, on the threads of pool unless it is NULL;
+   the inputs are handed out in chunks of similar size, so that a few very
+   large ones do not hold up the rest */
+void hash_batch_run(const hash_batch *b, thread_pool *pool);
+
+#endif /* _HASH_BATCH_H */
@@ -0,0 +1,210 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <string.h>
+
+#include "hasher.h"
+#include "zlib.h"
+#include "pmurhash.h"
+#include "crc32c.h"
+#include "blake3_threads.h"
+
+unsigned long ZEXPORT digest_crc32(unsigned long crc,
+                                   const unsigned char FAR *buf,
+                                   size_t len);
+
+/* Several of the older implementations take their length as a 32-bit
+   (or even signed) integer, so larger buffers are fed in pieces */
+#define HASHER_MAX_UPDATE ((size_t) 1 << 30)
+
+static void _store_be32(unsigned char *out, const uint32_t val) {
+    out[0] = (unsigned char) (val >> 24);
+    out[1] = (unsigned char) (val >> 16);
+    out[2] = (unsigned char) (val >> 8);
+    out[3] = (unsigned char) val;
+}
+
+static void _store_be64(unsigned char *out, const uint64_t val) {
+    _store_be32(out, (uint32_t) (val >> 32));
+    _store_be32(out + 4, (uint32_t) val);
+}
+
+int hasher_init(digest_hasher *h, const int algo, const uint32_t seed) {
+    h->algo = algo;
+    h->pool = NULL;
+    switch (algo) {
+    case 1:                     /* md5 */
+        md5_starts(&h->ctx.md5);
+        return 16;
+    case 2:                     /* sha1 */
+        sha1_starts(&h->ctx.sha1);
+        return 20;
+    case 3:                     /* crc32 */
+        h->ctx.crc32 = digest_crc32(0L, 0, 0);
+        return 4;
+    case 4:                     /* sha256 */
+        sha256_starts(&h->ctx.sha256);
+        return 32;
+    case 5:                     /* sha2-512 */
+        SHA512_Init(&h->ctx.sha512);
+        return SHA512_DIGEST_LENGTH;
+    case 6:                     /* xxhash32 */
+        XXH32_reset(&h->ctx.xxh32, seed);
+        return 4;
+    case 7:                     /* xxhash64 */
+        XXH64_reset(&h->ctx.xxh64, seed);
+        return 8;
+    case 8:                     /* murmur32 */
+        h->ctx.murmur.h1 = seed;
+        h->ctx.murmur.carry = 0;
+        h->ctx.murmur.total = 0;
+        return 4;
+    case 10:                    /* blake3 */
+        blake3_hasher_init(&h->ctx.blake3);
+        return BLAKE3_OUT_LEN;
+    case 11:                    /* crc32c */
+        h->ctx.crc32c = 0;
+        return 4;
+    case 12:                    /* xxh3_64 */
+        XXH3_INITSTATE(&h->ctx.xxh3); /* state lives on the stack */
+        XXH3_64bits_reset_withSeed(&h->ctx.xxh3, seed);
+        return 8;
+    case 13:                    /* xxh3_128 */
+        XXH3_INITSTATE(&h->ctx.xxh3); /* state lives on the stack */
+        XXH3_128bits_reset_withSeed(&h->ctx.xxh3, seed);
+        return 16;
+    default:
+        return -1;
+    }
+}
+
+int hasher_init_blake3(digest_hasher *h, const unsigned char *key, const char *context) {
+    h->algo = 10;
+    h->pool = NULL;
+    if (key != NULL) blake3_hasher_init_keyed(&h->ctx.blake3, key);
+    else blake3_hasher_init_derive_key(&h->ctx.blake3, context);
+    return BLAKE3_OUT_LEN;
+}
+
+void hasher_update(digest_hasher *h, const unsigned char *buf, size_t len) {
+    while (len > 0) {
+        size_t n = len > HASHER_MAX_UPDATE ? HASHER_MAX_UPDATE : len;
+        switch (h->algo) {
+        case 1:
+            md5_update(&h->ctx.md5, (uint8 *) buf, n);
+            break;
+        case 2:
+            sha1_update(&h->ctx.sha1, (uint8 *) buf, n);
+            break;
+        case 3:
+            h->ctx.crc32 = digest_crc32(h->ctx.crc32, buf, n);
+            break;
+        case 4:
+            sha256_update(&h->ctx.sha256, (uint8 *) buf, n);
+            break;
+        case 5:
+            SHA512_Update(&h->ctx.sha512, buf, n);
+            break;
+        case 6:
+            XXH32_update(&h->ctx.xxh32, buf, n);
+            break;
+        case 7:
+            XXH64_update(&h->ctx.xxh64, buf, n);
+            break;
+        case 8:
+            PMurHash32_Process(&h->ctx.murmur.h1, &h->ctx.murmur.carry, buf, (int) n);
+            h->ctx.murmur.total += (uint32_t) n;
+            break;
+        case 10:
+            blake3_hasher_update_pool(&h->ctx.blake3, buf, n, h->pool);
+            break;
+        case 11:
+            h->ctx.crc32c = crc32c_extend(h->ctx.crc32c, (const uint8_t *) buf, n);
+            break;
+        case 12:
+            XXH3_64bits_update(&h->ctx.xxh3, buf, n);
+            break;
+        case 13:
+            XXH3_128bits_update(&h->ctx.xxh3, buf, n);
+            break;
+        }
+        buf += n;
+        len -= n;
+    }
+}
+
+void hasher_update_chunk(void *data, const unsigned char *buf, size_t len) {
+    hasher_update((digest_hasher *) data, buf, len);
+}
+
+int hasher_final(digest_hasher *h, unsigned char *out) {
+    switch (h->algo) {
+    case 1:
+        md5_finish(&h->ctx.md5, out);
+        return 16;
+    case 2:
+        sha1_finish(&h->ctx.sha1, out);
+        return 20;
+    case 3:
+        _store_be32(out, (uint32_t) h->ctx.crc32);
+        return 4;
+    case 4:
+        sha256_finish(&h->ctx.sha256, out);
+        return 32;
+    case 5:
+        SHA512_Final(out, &h->ctx.sha512);
+        return SHA512_DIGEST_LENGTH;
+    case 6:
+        _store_be32(out, XXH32_digest(&h->ctx.xxh32));
+        return 4;
+    case 7:
+        _store_be64(out, XXH64_digest(&h->ctx.xxh64));
+        return 8;
+    case 8:
+        _store_be32(out, PMurHash32_Result(h->ctx.murmur.h1, h->ctx.murmur.carry,
+                                           h->ctx.murmur.total));
+        return 4;
+    case 10:
+        blake3_hasher_finalize(&h->ctx.blake3, out, BLAKE3_OUT_LEN);
+        return BLAKE3_OUT_LEN;
+    case 11:
+        _store_be32(out, h->ctx.crc32c);
+        return 4;
+    case 12:
+        _store_be64(out, XXH3_64bits_digest(&h->ctx.xxh3));
+        return 8;
+    case 13: {
+        XXH128_canonical_t canon;
+        XXH128_canonicalFromHash(&canon, XXH3_128bits_digest(&h->ctx.xxh3));
+        memcpy(out, &canon, 16);
+        return 16;
+    }
+    default:
+        return -1;
+    }
+}
+
+void hasher_final_len(digest_hasher *h, unsigned char *out, size_t len) {
+    if (h->algo == 10) blake3_hasher_finalize(&h->ctx.blake3, out, len);
+    else hasher_final(h, out);
+}
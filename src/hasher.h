@@ -0,0 +1,86 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _HASHER_H
+#define _HASHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define XXH_STATIC_LINKING_ONLY /* need the state types to embed them */
+#include "xxhash.h"
+#include "sha1.h"
+#include "sha2.h"
+#include "sha256.h"
+#include "md5.h"
+#include "blake3.h"
+#include "thread_pool.h"
+
+/* largest digest produced by any algorithm, i.e. sha512 */
+#define HASHER_MAX_OUTPUT 64
+
+/* A single incremental interface over all algorithms, using the same
+   algorithm codes as digest() (without the offset of 100 for files).
+   The state is held inline so no allocation is needed, which keeps it
+   safe to use from code that may longjmp out via error(). An optional
+   thread pool, owned by the caller, is used by the algorithms that can
+   split their input, currently blake3. */
+typedef struct {
+    int algo;
+    thread_pool *pool;
+    union {
+        md5_context md5;
+        sha1_context sha1;
+        sha256_context sha256;
+        SHA512_CTX sha512;
+        unsigned long crc32;
+        XXH32_state_t xxh32;
+        XXH64_state_t xxh64;
+        struct {
+            uint32_t h1;
+            uint32_t carry;
+            uint32_t total;
+        } murmur;
+        blake3_hasher blake3;
+        uint32_t crc32c;
+        XXH3_state_t xxh3;
+    } ctx;
+} digest_hasher;
+
+/* returns the digest length in bytes, or -1 for an unsupported algorithm;
+   the pool is reset to NULL */
+int hasher_init(digest_hasher *h, const int algo, const uint32_t seed);
+void hasher_update(digest_hasher *h, const unsigned char *buf, size_t len);
+/* blake3 in its keyed mode with a key of BLAKE3_KEY_LEN bytes, or else in
+   its key derivation mode with a context string; returns BLAKE3_OUT_LEN */
+int hasher_init_blake3(digest_hasher *h, const unsigned char *key, const char *context);
+/* hasher_update() in the shape of a file_reader callback */
+void hasher_update_chunk(void *data, const unsigned char *buf, size_t len);
+/* writes the digest in its canonical (big endian) byte order, as raw=TRUE
+   returns it, and returns its length */
+int hasher_final(digest_hasher *h, unsigned char *out);
+/* as hasher_final(), but writes len bytes: for blake3 any number of them,
+   its extendable output, for the others the digest length */
+void hasher_final_len(digest_hasher *h, unsigned char *out, size_t len);
+
+#endif /* _HASHER_H */
@@ -0,0 +1,68 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "hex.h"
+
+static const char hex_pairs[] =
+    "000102030405060708090a0b0c0d0e0f"
+    "101112131415161718191a1b1c1d1e1f"
+    "202122232425262728292a2b2c2d2e2f"
+    "303132333435363738393a3b3c3d3e3f"
+    "404142434445464748494a4b4c4d4e4f"
+    "505152535455565758595a5b5c5d5e5f"
+    "606162636465666768696a6b6c6d6e6f"
+    "707172737475767778797a7b7c7d7e7f"
+    "808182838485868788898a8b8c8d8e8f"
+    "909192939495969798999a9b9c9d9e9f"
+    "a0a1a2a3a4a5a6a7a8a9aaabacadaeaf"
+    "b0b1b2b3b4b5b6b7b8b9babbbcbdbebf"
+    "c0c1c2c3c4c5c6c7c8c9cacbcccdcecf"
+    "d0d1d2d3d4d5d6d7d8d9dadbdcdddedf"
+    "e0e1e2e3e4e5e6e7e8e9eaebecedeeef"
+    "f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff";
+
+void hex_encode(char *out, const unsigned char *in, size_t n) {
+#if DIGEST_X86_SIMD
+    if (n >= 16) {
+        int features = cpu_x86_features();
+        if (n >= 32 && (features & CPU_X86_AVX2)) {
+            size_t k = n & ~(size_t) 31;
+            hex_encode_avx2(out, in, k);
+            out += 2 * k;
+            in += k;
+            n -= k;
+        }
+        if (n >= 16 && (features & CPU_X86_SSSE3)) {
+            size_t k = n & ~(size_t) 15;
+            hex_encode_ssse3(out, in, k);
+            out += 2 * k;
+            in += k;
+            n -= k;
+        }
+    }
+#endif
+    for (size_t i = 0; i < n; i++) {
+        out[2 * i] = hex_pairs[2 * in[i]];
+        out[2 * i + 1] = hex_pairs[2 * in[i] + 1];
+    }
+}
@@ -0,0 +1,43 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _HEX_H
+#define _HEX_H
+
+#include <stddef.h>
+
+#include "cpu_features.h"
+
+/* Writes the 2 * n lowercase hex digits of in[0], ..., in[n - 1] to out,
+   without a terminating NUL. Runs of digests are best encoded in one
+   call, which lets the SSSE3 and AVX2 kernels take 16 or 32 bytes at a
+   time; shorter inputs go through a table of digit pairs. */
+void hex_encode(char *out, const unsigned char *in, size_t n);
+
+#if DIGEST_X86_SIMD
+/* the kernels behind hex_encode(), for n a multiple of 16 or 32 */
+void hex_encode_ssse3(char *out, const unsigned char *in, size_t n);
+void hex_encode_avx2(char *out, const unsigned char *in, size_t n);
+#endif
+
+#endif /* _HEX_H */
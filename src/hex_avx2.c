@@ -0,0 +1,72 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Hex digits for 32 bytes at a time, as in hex_ssse3.c; the unpacking
+   works within 128-bit lanes, so the halves are put in order afterwards. */
+
+#include "hex.h"
+
+#if DIGEST_X86_SIMD
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+#endif
+
+void hex_encode_avx2(char *out, const unsigned char *in, size_t n) {
+    const __m256i digits = _mm256_setr_epi8('0', '1', '2', '3', '4', '5', '6', '7',
+                                            '8', '9', 'a', 'b', 'c', 'd', 'e', 'f',
+                                            '0', '1', '2', '3', '4', '5', '6', '7',
+                                            '8', '9', 'a', 'b', 'c', 'd', 'e', 'f');
+    const __m256i mask = _mm256_set1_epi8(0x0f);
+
+    for (size_t i = 0; i < n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i *) (in + i));
+        __m256i hi = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+        __m256i lo = _mm256_shuffle_epi8(digits, _mm256_and_si256(v, mask));
+        __m256i a = _mm256_unpacklo_epi8(hi, lo);  /* bytes 0-7 and 16-23 */
+        __m256i b = _mm256_unpackhi_epi8(hi, lo);  /* bytes 8-15 and 24-31 */
+        _mm256_storeu_si256((__m256i *) (out + 2 * i), _mm256_permute2x128_si256(a, b, 0x20));
+        _mm256_storeu_si256((__m256i *) (out + 2 * i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+    }
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#else
+
+typedef int hex_avx2_unused;
+
+#endif
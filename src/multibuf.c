@@ -0,0 +1,236 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <string.h>
+
+#include "multibuf.h"
+#include "md5.h"
+#include "sha1.h"
+#include "sha256.h"
+#include "sha_ni.h"
+
+#define MB_MAX_LANES 16
+#define MB_IDLE ((size_t) -1)
+
+/* the scalar update functions take their length as a 32-bit integer */
+#define MB_MAX_UPDATE ((size_t) 1 << 30)
+
+typedef void (*mb_compress_fn)(uint32_t *state, const unsigned char *const *blocks);
+
+typedef struct {
+    int words;                  /* 32-bit words of chaining value */
+    int outlen;
+    int big_endian;             /* byte order of the length field and the digest */
+    uint32_t iv[8];
+} mb_algo;
+
+static const mb_algo mb_md5 =
+    { 4, 16, 0, { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476 } };
+static const mb_algo mb_sha1 =
+    { 5, 20, 1, { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 } };
+static const mb_algo mb_sha256 =
+    { 8, 32, 1, { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+                  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 } };
+
+typedef struct {
+    size_t msg;                 /* index of the message, or MB_IDLE */
+    const unsigned char *p;     /* its unprocessed part, left bytes long */
+    size_t left;
+    uint64_t len;
+    int ntail, itail;           /* padded final blocks, and those done */
+    unsigned char tail[128];
+} mb_lane;
+
+/* picks the widest kernel for the algorithm; on CPUs with the SHA
+   extensions sha1 and sha256 only gain from sixteen lanes, and are
+   otherwise left to hash one message at a time */
+static int _mb_select(const int algo, mb_compress_fn *fn, const mb_algo **desc) {
+#if DIGEST_X86_SIMD
+    int features = cpu_x86_features();
+    int wide = (features & CPU_X86_AVX512) ? 16 : (features & CPU_X86_AVX2) ? 8 : 4;
+
+    switch (algo) {
+    case 1:
+        *desc = &mb_md5;
+        *fn = wide == 16 ? md5_mb_avx512 : wide == 8 ? md5_mb_avx2 : md5_mb_sse2;
+        return wide;
+    case 2:
+        if (wide < 16 && sha_ni_available()) return 0;
+        *desc = &mb_sha1;
+        *fn = wide == 16 ? sha1_mb_avx512 : wide == 8 ? sha1_mb_avx2 : sha1_mb_sse2;
+        return wide;
+    case 4:
+        if (wide < 16 && sha_ni_available()) return 0;
+        *desc = &mb_sha256;
+        *fn = wide == 16 ? sha256_mb_avx512 : wide == 8 ? sha256_mb_avx2 : sha256_mb_sse2;
+        return wide;
+    }
+#else
+    (void) algo; (void) fn; (void) desc;
+#endif
+    return 0;
+}
+
+int multibuf_lanes(const int algo) {
+    mb_compress_fn fn;
+    const mb_algo *desc;
+    return _mb_select(algo, &fn, &desc);
+}
+
+static void _mb_store32(unsigned char *out, const uint32_t v, const int big_endian) {
+    if (big_endian) {
+        out[0] = (unsigned char) (v >> 24); out[1] = (unsigned char) (v >> 16);
+        out[2] = (unsigned char) (v >> 8);  out[3] = (unsigned char) v;
+    } else {
+        out[0] = (unsigned char) v;         out[1] = (unsigned char) (v >> 8);
+        out[2] = (unsigned char) (v >> 16); out[3] = (unsigned char) (v >> 24);
+    }
+}
+
+static void _mb_lane_start(const mb_algo *desc, uint32_t *state, const int lanes,
+                           const int l, mb_lane *lane, const size_t msg,
+                           const unsigned char *p, const size_t len) {
+    for (int j = 0; j < desc->words; j++)
+        state[j * lanes + l] = desc->iv[j];
+    lane->msg = msg;
+    lane->p = p;
+    lane->left = len;
+    lane->len = (uint64_t) len;
+    lane->ntail = lane->itail = 0;
+}
+
+/* the next block of the lane's message, padding it once less than a block is left */
+static const unsigned char *_mb_lane_block(const mb_algo *desc, mb_lane *lane) {
+    if (lane->ntail == 0) {
+        if (lane->left >= 64) return lane->p;
+
+        uint64_t bits = lane->len << 3;
+        size_t r = lane->left;
+        lane->ntail = r < 56 ? 1 : 2;
+        memcpy(lane->tail, lane->p, r);
+        lane->tail[r] = 0x80;
+        memset(lane->tail + r + 1, 0, lane->ntail * 64 - r - 1);
+        unsigned char *lenfield = lane->tail + lane->ntail * 64 - 8;
+        _mb_store32(lenfield + (desc->big_endian ? 0 : 4), (uint32_t) (bits >> 32), desc->big_endian);
+        _mb_store32(lenfield + (desc->big_endian ? 4 : 0), (uint32_t) bits, desc->big_endian);
+    }
+    return lane->tail + 64 * lane->itail;
+}
+
+/* returns non-zero once the lane's message is complete */
+static int _mb_lane_advance(mb_lane *lane) {
+    if (lane->ntail == 0) {
+        lane->p += 64;
+        lane->left -= 64;
+        return 0;
+    }
+    return ++lane->itail == lane->ntail;
+}
+
+/* completes the lane's message with the scalar code, which is faster than
+   a vector kernel with a single lane in use; only before padding started */
+static void _mb_lane_finish_scalar(const int algo, const uint32_t *state, const int lanes,
+                                   const int l, const mb_lane *lane, unsigned char *out) {
+    uint64_t done = lane->len - lane->left;
+    const unsigned char *p = lane->p;
+    size_t left = lane->left;
+
+#define MB_FINISH_SCALAR(ctxtype, prefix, words)                        \
+    {                                                                   \
+        ctxtype ctx;                                                    \
+        ctx.total[0] = (uint32) (done & 0xFFFFFFFF);                    \
+        ctx.total[1] = (uint32) (done >> 32);                           \
+        for (int j = 0; j < words; j++)                                 \
+            ctx.state[j] = state[j * lanes + l];                        \
+        while (left > 0) {                                              \
+            size_t k = left > MB_MAX_UPDATE ? MB_MAX_UPDATE : left;     \
+            prefix##_update(&ctx, (uint8 *) p, (uint32) k);             \
+            p += k;                                                     \
+            left -= k;                                                  \
+        }                                                               \
+        prefix##_finish(&ctx, out);                                     \
+    }
+
+    switch (algo) {
+    case 1: MB_FINISH_SCALAR(md5_context, md5, 4); break;
+    case 2: MB_FINISH_SCALAR(sha1_context, sha1, 5); break;
+    case 4: MB_FINISH_SCALAR(sha256_context, sha256, 8); break;
+    }
+#undef MB_FINISH_SCALAR
+}
+
+void multibuf_digest(const int algo, const size_t n, const unsigned char *const *msgs,
+                     const size_t *lens, unsigned char *out) {
+    static const unsigned char idle_block[64] = { 0 };
+    uint32_t state[8 * MB_MAX_LANES];
+    const unsigned char *blocks[MB_MAX_LANES];
+    mb_lane lane[MB_MAX_LANES];
+    mb_compress_fn fn;
+    const mb_algo *desc;
+    int lanes = _mb_select(algo, &fn, &desc);
+    int active = 0;
+    size_t next = 0;
+
+    if (lanes == 0) return;     /* not reached, callers check multibuf_lanes() */
+
+    for (int l = 0; l < lanes; l++) {
+        if (next < n) {
+            _mb_lane_start(desc, state, lanes, l, &lane[l], next, msgs[next], lens[next]);
+            next++;
+            active++;
+        } else {
+            lane[l].msg = MB_IDLE;
+        }
+    }
+
+    while (active > 0) {
+        if (active == 1 && next == n) {
+            int l = 0;
+            while (lane[l].msg == MB_IDLE) l++;
+            if (lane[l].ntail == 0) {
+                _mb_lane_finish_scalar(algo, state, lanes, l, &lane[l],
+                                       out + lane[l].msg * desc->outlen);
+                break;
+            }
+        }
+
+        for (int l = 0; l < lanes; l++)
+            blocks[l] = lane[l].msg == MB_IDLE ? idle_block : _mb_lane_block(desc, &lane[l]);
+        fn(state, blocks);
+
+        for (int l = 0; l < lanes; l++) {
+            if (lane[l].msg == MB_IDLE || !_mb_lane_advance(&lane[l])) continue;
+
+            unsigned char *o = out + lane[l].msg * desc->outlen;
+            for (int j = 0; j < desc->words; j++)
+                _mb_store32(o + 4 * j, state[j * lanes + l], desc->big_endian);
+            if (next < n) {
+                _mb_lane_start(desc, state, lanes, l, &lane[l], next, msgs[next], lens[next]);
+                next++;
+            } else {
+                lane[l].msg = MB_IDLE;
+                active--;
+            }
+        }
+    }
+}
@@ -0,0 +1,59 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _MULTIBUF_H
+#define _MULTIBUF_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu_features.h"
+
+/* Hashing of many independent messages at once, one message per SIMD
+   lane. Messages are assigned to lanes as they become free, so that
+   ragged lengths keep all lanes busy; the results are those of hashing
+   each message on its own. */
+
+/* number of lanes used for the algorithm code (1 md5, 2 sha1, 4 sha256)
+   on this CPU, or 0 if hashing one message at a time is at least as fast */
+int multibuf_lanes(const int algo);
+
+/* hashes msgs[i] of lens[i] bytes into out + i * outlen for i < n, where
+   outlen is the digest size; only for algorithms with multibuf_lanes() > 0 */
+void multibuf_digest(const int algo, const size_t n, const unsigned char *const *msgs,
+                     const size_t *lens, unsigned char *out);
+
+#if DIGEST_X86_SIMD
+/* one block per lane; see multibuf_kernels.h */
+void md5_mb_sse2(uint32_t *state, const unsigned char *const *blocks);
+void sha1_mb_sse2(uint32_t *state, const unsigned char *const *blocks);
+void sha256_mb_sse2(uint32_t *state, const unsigned char *const *blocks);
+void md5_mb_avx2(uint32_t *state, const unsigned char *const *blocks);
+void sha1_mb_avx2(uint32_t *state, const unsigned char *const *blocks);
+void sha256_mb_avx2(uint32_t *state, const unsigned char *const *blocks);
+void md5_mb_avx512(uint32_t *state, const unsigned char *const *blocks);
+void sha1_mb_avx512(uint32_t *state, const unsigned char *const *blocks);
+void sha256_mb_avx512(uint32_t *state, const unsigned char *const *blocks);
+#endif
+
+#endif /* _MULTIBUF_H */
@@ -0,0 +1,69 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Multi-buffer md5, sha1 and sha256 in sixteen AVX-512 lanes; see multibuf_kernels.h. */
+
+#include "multibuf.h"
+
+#if DIGEST_X86_SIMD
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("avx512f")
+#endif
+
+#define MB_LANES 16
+#define MB_NAME(name) name##_avx512
+typedef __m512i mb_vec;
+
+#define mb_load(p)      _mm512_loadu_si512((const void *) (p))
+#define mb_store(p, v)  _mm512_storeu_si512((void *) (p), v)
+#define mb_set1(x)      _mm512_set1_epi32((int) (x))
+#define mb_add(a, b)    _mm512_add_epi32(a, b)
+#define mb_xor(a, b)    _mm512_xor_si512(a, b)
+#define mb_and(a, b)    _mm512_and_si512(a, b)
+#define mb_or(a, b)     _mm512_or_si512(a, b)
+#define mb_srl(v, n)    _mm512_srli_epi32(v, n)
+#define mb_rotl(v, n)   _mm512_rol_epi32(v, n)
+
+#include "multibuf_kernels.h"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#else
+
+typedef int multibuf_avx512_unused;
+
+#endif
@@ -0,0 +1,304 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Multi-buffer compression functions, hashing one 64-byte block of each of
+   MB_LANES independent messages per call, with lane i of every vector
+   belonging to message i. Included by multibuf_sse2.c, multibuf_avx2.c and
+   multibuf_avx512.c, which first define MB_LANES, MB_NAME(), the vector
+   type mb_vec and the operations
+
+     mb_load(p), mb_store(p, v)     unaligned loads and stores of MB_LANES words
+     mb_set1(x)                     broadcast of a 32-bit constant
+     mb_add, mb_xor, mb_and, mb_or  lane-wise 32-bit operations
+     mb_rotl(v, n), mb_srl(v, n)    rotation and shift by a constant
+
+   The state is kept word-major, i.e. word j of lane i is state[j * MB_LANES + i].
+   Rotations are only applied to variables, as the operands of some of the
+   macros above are evaluated more than once. */
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#define mb_bswap32(x) _byteswap_ulong(x)
+#else
+#define mb_bswap32(x) __builtin_bswap32(x)
+#endif
+
+#define mb_not(x) mb_xor(x, mb_set1(0xffffffff))
+#define mb_rotr(v, n) mb_rotl(v, 32 - (n))
+
+/* transposes word j of every lane's block into w[j] */
+static void MB_NAME(mb_load_block)(mb_vec w[16], const unsigned char *const *blocks,
+                                   const int big_endian) {
+    uint32_t buf[16 * MB_LANES];
+
+    for (int i = 0; i < MB_LANES; i++) {
+        for (int j = 0; j < 16; j++) {
+            uint32_t x;
+            memcpy(&x, blocks[i] + 4 * j, 4);
+            buf[j * MB_LANES + i] = big_endian ? mb_bswap32(x) : x;
+        }
+    }
+    for (int j = 0; j < 16; j++)
+        w[j] = mb_load(buf + j * MB_LANES);
+}
+
+/* ------------------------------------------------------------------ md5 */
+
+#define MB_MD5_F(x, y, z) mb_xor(z, mb_and(x, mb_xor(y, z)))
+#define MB_MD5_G(x, y, z) mb_xor(y, mb_and(z, mb_xor(x, y)))
+#define MB_MD5_H(x, y, z) mb_xor(mb_xor(x, y), z)
+#define MB_MD5_I(x, y, z) mb_xor(y, mb_or(x, mb_not(z)))
+
+#define MB_MD5_STEP(f, a, b, c, d, k, s, t)                             \
+    a = mb_add(a, mb_add(f(b, c, d), mb_add(w[k], mb_set1(t))));        \
+    a = mb_add(mb_rotl(a, s), b)
+
+void MB_NAME(md5_mb)(uint32_t *state, const unsigned char *const *blocks) {
+    mb_vec w[16], a, b, c, d;
+
+    MB_NAME(mb_load_block)(w, blocks, 0);
+    a = mb_load(state + 0 * MB_LANES);
+    b = mb_load(state + 1 * MB_LANES);
+    c = mb_load(state + 2 * MB_LANES);
+    d = mb_load(state + 3 * MB_LANES);
+
+    MB_MD5_STEP(MB_MD5_F, a, b, c, d,  0,  7, 0xd76aa478);
+    MB_MD5_STEP(MB_MD5_F, d, a, b, c,  1, 12, 0xe8c7b756);
+    MB_MD5_STEP(MB_MD5_F, c, d, a, b,  2, 17, 0x242070db);
+    MB_MD5_STEP(MB_MD5_F, b, c, d, a,  3, 22, 0xc1bdceee);
+    MB_MD5_STEP(MB_MD5_F, a, b, c, d,  4,  7, 0xf57c0faf);
+    MB_MD5_STEP(MB_MD5_F, d, a, b, c,  5, 12, 0x4787c62a);
+    MB_MD5_STEP(MB_MD5_F, c, d, a, b,  6, 17, 0xa8304613);
+    MB_MD5_STEP(MB_MD5_F, b, c, d, a,  7, 22, 0xfd469501);
+    MB_MD5_STEP(MB_MD5_F, a, b, c, d,  8,  7, 0x698098d8);
+    MB_MD5_STEP(MB_MD5_F, d, a, b, c,  9, 12, 0x8b44f7af);
+    MB_MD5_STEP(MB_MD5_F, c, d, a, b, 10, 17, 0xffff5bb1);
+    MB_MD5_STEP(MB_MD5_F, b, c, d, a, 11, 22, 0x895cd7be);
+    MB_MD5_STEP(MB_MD5_F, a, b, c, d, 12,  7, 0x6b901122);
+    MB_MD5_STEP(MB_MD5_F, d, a, b, c, 13, 12, 0xfd987193);
+    MB_MD5_STEP(MB_MD5_F, c, d, a, b, 14, 17, 0xa679438e);
+    MB_MD5_STEP(MB_MD5_F, b, c, d, a, 15, 22, 0x49b40821);
+
+    MB_MD5_STEP(MB_MD5_G, a, b, c, d,  1,  5, 0xf61e2562);
+    MB_MD5_STEP(MB_MD5_G, d, a, b, c,  6,  9, 0xc040b340);
+    MB_MD5_STEP(MB_MD5_G, c, d, a, b, 11, 14, 0x265e5a51);
+    MB_MD5_STEP(MB_MD5_G, b, c, d, a,  0, 20, 0xe9b6c7aa);
+    MB_MD5_STEP(MB_MD5_G, a, b, c, d,  5,  5, 0xd62f105d);
+    MB_MD5_STEP(MB_MD5_G, d, a, b, c, 10,  9, 0x02441453);
+    MB_MD5_STEP(MB_MD5_G, c, d, a, b, 15, 14, 0xd8a1e681);
+    MB_MD5_STEP(MB_MD5_G, b, c, d, a,  4, 20, 0xe7d3fbc8);
+    MB_MD5_STEP(MB_MD5_G, a, b, c, d,  9,  5, 0x21e1cde6);
+    MB_MD5_STEP(MB_MD5_G, d, a, b, c, 14,  9, 0xc33707d6);
+    MB_MD5_STEP(MB_MD5_G, c, d, a, b,  3, 14, 0xf4d50d87);
+    MB_MD5_STEP(MB_MD5_G, b, c, d, a,  8, 20, 0x455a14ed);
+    MB_MD5_STEP(MB_MD5_G, a, b, c, d, 13,  5, 0xa9e3e905);
+    MB_MD5_STEP(MB_MD5_G, d, a, b, c,  2,  9, 0xfcefa3f8);
+    MB_MD5_STEP(MB_MD5_G, c, d, a, b,  7, 14, 0x676f02d9);
+    MB_MD5_STEP(MB_MD5_G, b, c, d, a, 12, 20, 0x8d2a4c8a);
+
+    MB_MD5_STEP(MB_MD5_H, a, b, c, d,  5,  4, 0xfffa3942);
+    MB_MD5_STEP(MB_MD5_H, d, a, b, c,  8, 11, 0x8771f681);
+    MB_MD5_STEP(MB_MD5_H, c, d, a, b, 11, 16, 0x6d9d6122);
+    MB_MD5_STEP(MB_MD5_H, b, c, d, a, 14, 23, 0xfde5380c);
+    MB_MD5_STEP(MB_MD5_H, a, b, c, d,  1,  4, 0xa4beea44);
+    MB_MD5_STEP(MB_MD5_H, d, a, b, c,  4, 11, 0x4bdecfa9);
+    MB_MD5_STEP(MB_MD5_H, c, d, a, b,  7, 16, 0xf6bb4b60);
+    MB_MD5_STEP(MB_MD5_H, b, c, d, a, 10, 23, 0xbebfbc70);
+    MB_MD5_STEP(MB_MD5_H, a, b, c, d, 13,  4, 0x289b7ec6);
+    MB_MD5_STEP(MB_MD5_H, d, a, b, c,  0, 11, 0xeaa127fa);
+    MB_MD5_STEP(MB_MD5_H, c, d, a, b,  3, 16, 0xd4ef3085);
+    MB_MD5_STEP(MB_MD5_H, b, c, d, a,  6, 23, 0x04881d05);
+    MB_MD5_STEP(MB_MD5_H, a, b, c, d,  9,  4, 0xd9d4d039);
+    MB_MD5_STEP(MB_MD5_H, d, a, b, c, 12, 11, 0xe6db99e5);
+    MB_MD5_STEP(MB_MD5_H, c, d, a, b, 15, 16, 0x1fa27cf8);
+    MB_MD5_STEP(MB_MD5_H, b, c, d, a,  2, 23, 0xc4ac5665);
+
+    MB_MD5_STEP(MB_MD5_I, a, b, c, d,  0,  6, 0xf4292244);
+    MB_MD5_STEP(MB_MD5_I, d, a, b, c,  7, 10, 0x432aff97);
+    MB_MD5_STEP(MB_MD5_I, c, d, a, b, 14, 15, 0xab9423a7);
+    MB_MD5_STEP(MB_MD5_I, b, c, d, a,  5, 21, 0xfc93a039);
+    MB_MD5_STEP(MB_MD5_I, a, b, c, d, 12,  6, 0x655b59c3);
+    MB_MD5_STEP(MB_MD5_I, d, a, b, c,  3, 10, 0x8f0ccc92);
+    MB_MD5_STEP(MB_MD5_I, c, d, a, b, 10, 15, 0xffeff47d);
+    MB_MD5_STEP(MB_MD5_I, b, c, d, a,  1, 21, 0x85845dd1);
+    MB_MD5_STEP(MB_MD5_I, a, b, c, d,  8,  6, 0x6fa87e4f);
+    MB_MD5_STEP(MB_MD5_I, d, a, b, c, 15, 10, 0xfe2ce6e0);
+    MB_MD5_STEP(MB_MD5_I, c, d, a, b,  6, 15, 0xa3014314);
+    MB_MD5_STEP(MB_MD5_I, b, c, d, a, 13, 21, 0x4e0811a1);
+    MB_MD5_STEP(MB_MD5_I, a, b, c, d,  4,  6, 0xf7537e82);
+    MB_MD5_STEP(MB_MD5_I, d, a, b, c, 11, 10, 0xbd3af235);
+    MB_MD5_STEP(MB_MD5_I, c, d, a, b,  2, 15, 0x2ad7d2bb);
+    MB_MD5_STEP(MB_MD5_I, b, c, d, a,  9, 21, 0xeb86d391);
+
+    mb_store(state + 0 * MB_LANES, mb_add(a, mb_load(state + 0 * MB_LANES)));
+    mb_store(state + 1 * MB_LANES, mb_add(b, mb_load(state + 1 * MB_LANES)));
+    mb_store(state + 2 * MB_LANES, mb_add(c, mb_load(state + 2 * MB_LANES)));
+    mb_store(state + 3 * MB_LANES, mb_add(d, mb_load(state + 3 * MB_LANES)));
+}
+
+/* ----------------------------------------------------------------- sha1 */
+
+#define MB_SHA1_F1(x, y, z) mb_xor(z, mb_and(x, mb_xor(y, z)))
+#define MB_SHA1_F2(x, y, z) mb_xor(mb_xor(x, y), z)
+#define MB_SHA1_F3(x, y, z) mb_or(mb_and(x, y), mb_and(z, mb_or(x, y)))
+
+/* message word t, expanded in place in a 16-word window from round 16 on */
+#define MB_SHA1_W(t)                                                    \
+    ((t) < 16 ? w[(t) & 15] :                                           \
+     (wt = mb_xor(mb_xor(w[((t) - 3) & 15], w[((t) - 8) & 15]),         \
+                  mb_xor(w[((t) - 14) & 15], w[(t) & 15])),             \
+      w[(t) & 15] = mb_rotl(wt, 1)))
+
+#define MB_SHA1_STEP(f, k, a, b, c, d, e, t)                            \
+    tmp = mb_rotl(a, 5);                                                \
+    e = mb_add(e, mb_add(mb_add(tmp, f(b, c, d)),                       \
+                         mb_add(mb_set1(k), MB_SHA1_W(t))));            \
+    b = mb_rotl(b, 30)
+
+#define MB_SHA1_5(f, k, t)                                              \
+    MB_SHA1_STEP(f, k, a, b, c, d, e, (t));                             \
+    MB_SHA1_STEP(f, k, e, a, b, c, d, (t) + 1);                         \
+    MB_SHA1_STEP(f, k, d, e, a, b, c, (t) + 2);                         \
+    MB_SHA1_STEP(f, k, c, d, e, a, b, (t) + 3);                         \
+    MB_SHA1_STEP(f, k, b, c, d, e, a, (t) + 4)
+
+void MB_NAME(sha1_mb)(uint32_t *state, const unsigned char *const *blocks) {
+    mb_vec w[16], a, b, c, d, e, tmp, wt;
+
+    MB_NAME(mb_load_block)(w, blocks, 1);
+    a = mb_load(state + 0 * MB_LANES);
+    b = mb_load(state + 1 * MB_LANES);
+    c = mb_load(state + 2 * MB_LANES);
+    d = mb_load(state + 3 * MB_LANES);
+    e = mb_load(state + 4 * MB_LANES);
+
+    MB_SHA1_5(MB_SHA1_F1, 0x5a827999,  0);
+    MB_SHA1_5(MB_SHA1_F1, 0x5a827999,  5);
+    MB_SHA1_5(MB_SHA1_F1, 0x5a827999, 10);
+    MB_SHA1_5(MB_SHA1_F1, 0x5a827999, 15);
+
+    MB_SHA1_5(MB_SHA1_F2, 0x6ed9eba1, 20);
+    MB_SHA1_5(MB_SHA1_F2, 0x6ed9eba1, 25);
+    MB_SHA1_5(MB_SHA1_F2, 0x6ed9eba1, 30);
+    MB_SHA1_5(MB_SHA1_F2, 0x6ed9eba1, 35);
+
+    MB_SHA1_5(MB_SHA1_F3, 0x8f1bbcdc, 40);
+    MB_SHA1_5(MB_SHA1_F3, 0x8f1bbcdc, 45);
+    MB_SHA1_5(MB_SHA1_F3, 0x8f1bbcdc, 50);
+    MB_SHA1_5(MB_SHA1_F3, 0x8f1bbcdc, 55);
+
+    MB_SHA1_5(MB_SHA1_F2, 0xca62c1d6, 60);
+    MB_SHA1_5(MB_SHA1_F2, 0xca62c1d6, 65);
+    MB_SHA1_5(MB_SHA1_F2, 0xca62c1d6, 70);
+    MB_SHA1_5(MB_SHA1_F2, 0xca62c1d6, 75);
+
+    mb_store(state + 0 * MB_LANES, mb_add(a, mb_load(state + 0 * MB_LANES)));
+    mb_store(state + 1 * MB_LANES, mb_add(b, mb_load(state + 1 * MB_LANES)));
+    mb_store(state + 2 * MB_LANES, mb_add(c, mb_load(state + 2 * MB_LANES)));
+    mb_store(state + 3 * MB_LANES, mb_add(d, mb_load(state + 3 * MB_LANES)));
+    mb_store(state + 4 * MB_LANES, mb_add(e, mb_load(state + 4 * MB_LANES)));
+}
+
+/* --------------------------------------------------------------- sha256 */
+
+static const uint32_t MB_NAME(mb_sha256_k)[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+    0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+    0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+    0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+    0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+#define MB_SHA256_CH(x, y, z)  mb_xor(z, mb_and(x, mb_xor(y, z)))
+#define MB_SHA256_MAJ(x, y, z) mb_or(mb_and(x, y), mb_and(z, mb_or(x, y)))
+#define MB_SHA256_S0(x) mb_xor(mb_xor(mb_rotr(x, 2), mb_rotr(x, 13)), mb_rotr(x, 22))
+#define MB_SHA256_S1(x) mb_xor(mb_xor(mb_rotr(x, 6), mb_rotr(x, 11)), mb_rotr(x, 25))
+#define MB_SHA256_s0(x) mb_xor(mb_xor(mb_rotr(x, 7), mb_rotr(x, 18)), mb_srl(x, 3))
+#define MB_SHA256_s1(x) mb_xor(mb_xor(mb_rotr(x, 17), mb_rotr(x, 19)), mb_srl(x, 10))
+
+#define MB_SHA256_W(t)                                                  \
+    ((t) < 16 ? w[(t) & 15] :                                           \
+     (w[(t) & 15] = mb_add(mb_add(MB_SHA256_s1(w[((t) - 2) & 15]), w[((t) - 7) & 15]), \
+                           mb_add(MB_SHA256_s0(w[((t) - 15) & 15]), w[(t) & 15]))))
+
+#define MB_SHA256_STEP(a, b, c, d, e, f, g, h, t)                       \
+    h = mb_add(h, mb_add(mb_add(MB_SHA256_S1(e), MB_SHA256_CH(e, f, g)), \
+                         mb_add(mb_set1(MB_NAME(mb_sha256_k)[t]), MB_SHA256_W(t)))); \
+    d = mb_add(d, h);                                                   \
+    h = mb_add(h, mb_add(MB_SHA256_S0(a), MB_SHA256_MAJ(a, b, c)))
+
+#define MB_SHA256_8(t)                                                  \
+    MB_SHA256_STEP(a, b, c, d, e, f, g, h, (t));                        \
+    MB_SHA256_STEP(h, a, b, c, d, e, f, g, (t) + 1);                    \
+    MB_SHA256_STEP(g, h, a, b, c, d, e, f, (t) + 2);                    \
+    MB_SHA256_STEP(f, g, h, a, b, c, d, e, (t) + 3);                    \
+    MB_SHA256_STEP(e, f, g, h, a, b, c, d, (t) + 4);                    \
+    MB_SHA256_STEP(d, e, f, g, h, a, b, c, (t) + 5);                    \
+    MB_SHA256_STEP(c, d, e, f, g, h, a, b, (t) + 6);                    \
+    MB_SHA256_STEP(b, c, d, e, f, g, h, a, (t) + 7)
+
+void MB_NAME(sha256_mb)(uint32_t *state, const unsigned char *const *blocks) {
+    mb_vec w[16], a, b, c, d, e, f, g, h;
+
+    MB_NAME(mb_load_block)(w, blocks, 1);
+    a = mb_load(state + 0 * MB_LANES);
+    b = mb_load(state + 1 * MB_LANES);
+    c = mb_load(state + 2 * MB_LANES);
+    d = mb_load(state + 3 * MB_LANES);
+    e = mb_load(state + 4 * MB_LANES);
+    f = mb_load(state + 5 * MB_LANES);
+    g = mb_load(state + 6 * MB_LANES);
+    h = mb_load(state + 7 * MB_LANES);
+
+    MB_SHA256_8(0);
+    MB_SHA256_8(8);
+    MB_SHA256_8(16);
+    MB_SHA256_8(24);
+    MB_SHA256_8(32);
+    MB_SHA256_8(40);
+    MB_SHA256_8(48);
+    MB_SHA256_8(56);
+
+    mb_store(state + 0 * MB_LANES, mb_add(a, mb_load(state + 0 * MB_LANES)));
+    mb_store(state + 1 * MB_LANES, mb_add(b, mb_load(state + 1 * MB_LANES)));
+    mb_store(state + 2 * MB_LANES, mb_add(c, mb_load(state + 2 * MB_LANES)));
+    mb_store(state + 3 * MB_LANES, mb_add(d, mb_load(state + 3 * MB_LANES)));
+    mb_store(state + 4 * MB_LANES, mb_add(e, mb_load(state + 4 * MB_LANES)));
+    mb_store(state + 5 * MB_LANES, mb_add(f, mb_load(state + 5 * MB_LANES)));
+    mb_store(state + 6 * MB_LANES, mb_add(g, mb_load(state + 6 * MB_LANES)));
+    mb_store(state + 7 * MB_LANES, mb_add(h, mb_load(state + 7 * MB_LANES)));
+}
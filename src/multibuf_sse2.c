@@ -0,0 +1,69 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Multi-buffer md5, sha1 and sha256 in four SSE2 lanes; see multibuf_kernels.h. */
+
+#include "multibuf.h"
+
+#if DIGEST_X86_SIMD
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sse2")
+#endif
+
+#define MB_LANES 4
+#define MB_NAME(name) name##_sse2
+typedef __m128i mb_vec;
+
+#define mb_load(p)      _mm_loadu_si128((const __m128i *) (p))
+#define mb_store(p, v)  _mm_storeu_si128((__m128i *) (p), v)
+#define mb_set1(x)      _mm_set1_epi32((int) (x))
+#define mb_add(a, b)    _mm_add_epi32(a, b)
+#define mb_xor(a, b)    _mm_xor_si128(a, b)
+#define mb_and(a, b)    _mm_and_si128(a, b)
+#define mb_or(a, b)     _mm_or_si128(a, b)
+#define mb_srl(v, n)    _mm_srli_epi32(v, n)
+#define mb_rotl(v, n)   _mm_or_si128(_mm_slli_epi32(v, n), _mm_srli_epi32(v, 32 - (n)))
+
+#include "multibuf_kernels.h"
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+#else
+
+typedef int multibuf_sse2_unused;
+
+#endif
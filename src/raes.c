@@ -2,7 +2,15 @@
 /* This is a simple R interface to Christophe Devine's AES implementation */
 
 
+#include <string.h>
+
 #include "aes.h"
+#include "aes_ni.h"
+#include "ghash.h"
+#include "digest.h"
+#include "file_reader.h"
+#include "hasher.h"
+#include "thread_pool.h"
 #include <R.h>
 #include <Rinternals.h>
 
@@ -18,10 +26,118 @@ void decrypt(unsigned char *key, int *len, unsigned char *code) {
   aes_decrypt(&ctx, code, code);
 }
 
+/* The context of the AES() objects: the key schedule, followed by the
+   chaining state of the CBC, CFB and CTR modes. Each call continues from
+   the state the previous one left, as with the R loops these replace. */
+typedef struct {
+  aes_context aes;		/* first, so that it can be used as an aes_context */
+  unsigned char iv[16];		/* CBC: last ciphertext block, CFB: shift register,
+				   CTR: next counter block */
+  int iv_len;			/* as given, only 16 can be used but by GCM */
+  unsigned char *iv_full;	/* GCM: the IV as given, of iv_len bytes */
+  int cfb_num;			/* CFB: bytes of the register used by a partial block */
+  int nr_ni;			/* rounds of the keys below, 0 to use the tables */
+  unsigned char erk_ni[AES_NI_KEYS_LEN];	/* round keys for the AES instructions */
+  unsigned char drk_ni[AES_NI_KEYS_LEN];
+  ghash_key ghash;		/* GCM: the hash key, the encrypted zero block */
+  int gcm_used;			/* GCM: a message has been encrypted with the IV */
+} aes_mode_context;
+
+/* The modes are built on these, which use the AES instructions when the
+   context has keys for them, and the tables of aes.c otherwise. in and out
+   may be the same buffer. */
+static void _aes_encrypt_block(aes_mode_context *ctx, const unsigned char *in, unsigned char *out) {
+#if DIGEST_X86_SIMD
+  if (ctx->nr_ni) {
+    aes_ni_encrypt_ecb(ctx->erk_ni, ctx->nr_ni, in, out, 1);
+    return;
+  }
+#endif
+  aes_encrypt(&ctx->aes, (uint8 *) in, out);
+}
+
+static void _aes_encrypt_ecb(aes_mode_context *ctx, const unsigned char *in, unsigned char *out,
+                             size_t nblocks) {
+#if DIGEST_X86_SIMD
+  if (ctx->nr_ni) {
+    aes_ni_encrypt_ecb(ctx->erk_ni, ctx->nr_ni, in, out, nblocks);
+    return;
+  }
+#endif
+  for (; nblocks > 0; nblocks--, in += 16, out += 16)
+    aes_encrypt(&ctx->aes, (uint8 *) in, out);
+}
+
+static void _aes_decrypt_ecb(aes_mode_context *ctx, const unsigned char *in, unsigned char *out,
+                             size_t nblocks) {
+#if DIGEST_X86_SIMD
+  if (ctx->nr_ni) {
+    aes_ni_decrypt_ecb(ctx->drk_ni, ctx->nr_ni, in, out, nblocks);
+    return;
+  }
+#endif
+  for (; nblocks > 0; nblocks--, in += 16, out += 16)
+    aes_decrypt(&ctx->aes, (uint8 *) in, out);
+}
+
+/* iv is left at the last ciphertext block */
+static void _aes_encrypt_cbc(aes_mode_context *ctx, unsigned char iv[16], const unsigned char *in,
+                             unsigned char *out, size_t nblocks) {
+#if DIGEST_X86_SIMD
+  if (ctx->nr_ni) {
+    aes_ni_encrypt_cbc(ctx->erk_ni, ctx->nr_ni, iv, in, out, nblocks);
+    return;
+  }
+#endif
+  for (; nblocks > 0; nblocks--, in += 16, out += 16) {
+    for (int j = 0; j < 16; j++) out[j] = in[j] ^ iv[j];
+    aes_encrypt(&ctx->aes, out, out);
+    memcpy(iv, out, 16);
+  }
+}
+
+static void _aes_decrypt_cbc(aes_mode_context *ctx, unsigned char iv[16], const unsigned char *in,
+                             unsigned char *out, size_t nblocks) {
+  unsigned char next[16];
+#if DIGEST_X86_SIMD
+  if (ctx->nr_ni) {
+    aes_ni_decrypt_cbc(ctx->drk_ni, ctx->nr_ni, iv, in, out, nblocks);
+    return;
+  }
+#endif
+  for (; nblocks > 0; nblocks--, in += 16, out += 16) {
+    memcpy(next, in, 16);
+    aes_decrypt(&ctx->aes, (uint8 *) in, out);
+    for (int j = 0; j < 16; j++) out[j] ^= iv[j];
+    memcpy(iv, next, 16);
+  }
+}
+
+/* len need not be a multiple of 16; the big endian counter ctr is advanced
+   once for every block started */
+static void _aes_ctr(aes_mode_context *ctx, unsigned char ctr[16], const unsigned char *in,
+                     unsigned char *out, size_t len) {
+  unsigned char keystream[16];
+#if DIGEST_X86_SIMD
+  if (ctx->nr_ni) {
+    aes_ni_ctr(ctx->erk_ni, ctx->nr_ni, ctr, in, out, len);
+    return;
+  }
+#endif
+  for (size_t i = 0; i < len; i += 16) {
+    size_t n = len - i < 16 ? len - i : 16;
+    aes_encrypt(&ctx->aes, ctr, keystream);
+    for (size_t j = 0; j < n; j++) out[i + j] = in[i + j] ^ keystream[j];
+    for (int j = 15; j >= 0 && ++ctr[j] == 0; j--)
+      ;
+  }
+}
+
 static void AESFinalizer(SEXP ptr)
 {
-  void *ctx = R_ExternalPtrAddr(ptr);
+  aes_mode_context *ctx = (aes_mode_context *) R_ExternalPtrAddr(ptr);
   if (!ctx) return;
+  if (ctx->iv_full) R_Free(ctx->iv_full);
   R_Free(ctx);
   R_ClearExternalPtr(ptr);
 } /* #nocov end */
@@ -31,7 +147,7 @@ SEXP AESinit(SEXP key) {
   int status;
   SEXP result;
   
-  aes_context *ctx;
+  aes_mode_context *ctx;
   
   if (TYPEOF(key) != RAWSXP)
     error("key must be a raw vector"); 				/* #nocov */
@@ -39,11 +155,20 @@ SEXP AESinit(SEXP key) {
   if (nbits != 128 && nbits != 192 && nbits != 256)
     error("AES only supports 16, 24 and 32 byte keys"); 	/* #nocov */
 
-  ctx = (aes_context*)R_Calloc(sizeof(*ctx), char);
+  ctx = (aes_mode_context*)R_Calloc(sizeof(*ctx), char);
 
-  status = aes_set_key(ctx, (uint8 *) RAW(key), nbits);
+  status = aes_set_key(&ctx->aes, (uint8 *) RAW(key), nbits);
   if (status)
     error("AES initialization failed");				/* #nocov */
+#if DIGEST_X86_SIMD
+  if (aes_ni_available())
+    ctx->nr_ni = aes_ni_set_key(ctx->erk_ni, ctx->drk_ni, RAW(key), nbits);
+#endif
+  {
+    unsigned char h[16] = {0};
+    _aes_encrypt_block(ctx, h, h);
+    ghash_init(&ctx->ghash, h);
+  }
   
   result = R_MakeExternalPtr(ctx, install("AES_context"), R_NilValue);
   PROTECT(result);
@@ -52,49 +177,695 @@ SEXP AESinit(SEXP key) {
   return result;
 }
 
-SEXP AESencryptECB(SEXP context, SEXP text) {
-  aes_context *ctx = R_ExternalPtrAddr(context);
-  int len = length(text);
-  unsigned char *block;
-  
-  if (!ctx) 
-    error("AES context not initialized"); 			/* #nocov */
+/* the modes whose blocks do not depend on each other, which can be split
+   over several threads */
+typedef enum { AES_ENCRYPT_ECB, AES_DECRYPT_ECB, AES_DECRYPT_CBC, AES_CTR } aes_op;
+
+/* inputs this long at least are split over threads, if asked for */
+#define AES_THREADS_MIN_LEN ((size_t) 1 << 20)
+
+typedef struct {
+  pool_task task;
+  aes_mode_context *ctx;
+  aes_op op;
+  unsigned char iv[16];		/* CBC: the ciphertext block before the segment,
+				   CTR: the counter of its first block */
+  unsigned char *buf;
+  size_t len;
+} aes_job;
+
+static void _aes_run(aes_mode_context *ctx, aes_op op, unsigned char iv[16],
+                     unsigned char *buf, size_t len) {
+  switch (op) {
+  case AES_ENCRYPT_ECB: _aes_encrypt_ecb(ctx, buf, buf, len / 16); break;
+  case AES_DECRYPT_ECB: _aes_decrypt_ecb(ctx, buf, buf, len / 16); break;
+  case AES_DECRYPT_CBC: _aes_decrypt_cbc(ctx, iv, buf, buf, len / 16); break;
+  case AES_CTR:         _aes_ctr(ctx, iv, buf, buf, len); break;
+  }
+}
+
+static void _aes_job_run(void *arg) {
+  aes_job *job = (aes_job *) arg;
+  _aes_run(job->ctx, job->op, job->iv, job->buf, job->len);
+}
+
+/* adds n to the big endian counter ctr */
+static void _aes_ctr_add(unsigned char ctr[16], size_t n) {
+  unsigned long long carry = n;
+  for (int j = 15; j >= 0 && carry; j--) {
+    carry += ctr[j];
+    ctr[j] = (unsigned char) carry;
+    carry >>= 8;
+  }
+}
+
+/* transforms buf in place, in one block-aligned segment per thread of
+   pool, with jobs holding one aes_job per thread; iv is left as a single
+   pass would have left it. No R API is used, so that a pool and jobs set
+   up once can serve many calls. */
+static void _aes_threads_run(aes_mode_context *ctx, aes_op op, unsigned char iv[16],
+                             unsigned char *buf, size_t len, thread_pool *pool, aes_job *jobs) {
+  size_t nblocks = (len + 15) / 16, per, njobs = 0;
+
+  if (pool == NULL || len < AES_THREADS_MIN_LEN) {
+    _aes_run(ctx, op, iv, buf, len);
+    return;
+  }
+  per = (nblocks + thread_pool_size(pool) - 1) / thread_pool_size(pool);
+  for (size_t first = 0; first < nblocks; first += per, njobs++) {
+    aes_job *job = jobs + njobs;
+    size_t offset = 16 * first;
+    job->task.fn = _aes_job_run;
+    job->task.arg = job;
+    job->ctx = ctx;
+    job->op = op;
+    job->buf = buf + offset;
+    job->len = len - offset < 16 * per ? len - offset : 16 * per;
+    if (op == AES_DECRYPT_CBC)	/* taken before any segment is overwritten */
+      memcpy(job->iv, first > 0 ? buf + offset - 16 : iv, 16);
+    if (op == AES_CTR) {
+      memcpy(job->iv, iv, 16);
+      _aes_ctr_add(job->iv, first);
+    }
+  }
+  if (op == AES_DECRYPT_CBC) memcpy(iv, buf + 16 * (nblocks - 1), 16);
+  if (op == AES_CTR) _aes_ctr_add(iv, nblocks);
+
+  for (size_t j = 0; j < njobs; j++) thread_pool_submit(pool, &jobs[j].task);
+  for (size_t j = 0; j < njobs; j++) thread_pool_wait(pool, &jobs[j].task);
+}
+
+/* the same with a pool of the given number of threads for this call */
+static void _aes_threads(aes_mode_context *ctx, aes_op op, unsigned char iv[16],
+                         unsigned char *buf, size_t len, int threads) {
+  aes_job *jobs;
+  thread_pool *pool;
+
+  if (threads < 2 || len < AES_THREADS_MIN_LEN) {
+    _aes_run(ctx, op, iv, buf, len);
+    return;
+  }
+  jobs = (aes_job *) R_alloc(threads, sizeof(*jobs));
+  pool = thread_pool_create(threads);
+  _aes_threads_run(ctx, op, iv, buf, len, pool, jobs);
+  if (pool != NULL) thread_pool_destroy(pool);
+}
+
+static aes_mode_context *_aes_get(SEXP context) {
+  aes_mode_context *ctx = R_ExternalPtrAddr(context);
+  if (!ctx)
+    error("AES context not initialized");			/* #nocov */
+  return ctx;
+}
+
+SEXP AESencryptECB(SEXP context, SEXP text, SEXP Threads) {
+  aes_mode_context *ctx = _aes_get(context);
+  R_xlen_t len = xlength(text);
+
   if (TYPEOF(text) != RAWSXP)
     error("Text must be a raw vector");				/* #nocov */
   if (len % 16)
     error("Text length must be a multiple of 16 bytes");	/* #nocov */
   
   if (MAYBE_REFERENCED(text)) text = duplicate(text);
-  
-  block = RAW(text);
-  while (len > 0) {
-    aes_encrypt(ctx, block, block);
-    block += 16;
-    len -= 16;
-  }
+
+  _aes_threads(ctx, AES_ENCRYPT_ECB, NULL, RAW(text), len, asInteger(Threads));
   return(text);
 }
 
-SEXP AESdecryptECB(SEXP context, SEXP ciphertext) {
-  aes_context *ctx = R_ExternalPtrAddr(context);
-  int len = length(ciphertext);
-  unsigned char *block;
-  
-  if (!ctx) 
-    error("AES context not initialized");			/* #nocov */
+SEXP AESdecryptECB(SEXP context, SEXP ciphertext, SEXP Threads) {
+  aes_mode_context *ctx = _aes_get(context);
+  R_xlen_t len = xlength(ciphertext);
+
   if (TYPEOF(ciphertext) != RAWSXP)
     error("Ciphertext must be a raw vector");			/* #nocov */
   if (len % 16)
     error("Ciphertext length must be a multiple of 16 bytes");	/* #nocov */
   
   if (MAYBE_REFERENCED(ciphertext)) ciphertext = duplicate(ciphertext);
-  
-  block = RAW(ciphertext);
-  
+
+  _aes_threads(ctx, AES_DECRYPT_ECB, NULL, RAW(ciphertext), len, asInteger(Threads));
+  return(ciphertext);
+}
+
+static aes_mode_context *_aes_get_iv(SEXP context) {
+  aes_mode_context *ctx = _aes_get(context);
+  if (ctx->iv_len != 16)
+    error("IV length must equal block size");
+  return ctx;
+}
+
+/* the result is a fresh copy of the input, transformed in place */
+static SEXP _aes_copy(SEXP text, const char *what) {
+  if (TYPEOF(text) != RAWSXP)
+    error("%s must be a raw vector", what);			/* #nocov */
+  return duplicate(text);
+}
+
+SEXP AESsetIV(SEXP context, SEXP IV) {
+  aes_mode_context *ctx = _aes_get(context);
+
+  if (TYPEOF(IV) != RAWSXP)
+    error("IV must be a raw vector");				/* #nocov */
+  if (ctx->iv_full) R_Free(ctx->iv_full);
+  ctx->iv_len = 0;
+  if (LENGTH(IV) > 0) {
+    ctx->iv_full = R_Calloc(LENGTH(IV), unsigned char);
+    memcpy(ctx->iv_full, RAW(IV), LENGTH(IV));
+  }
+  ctx->iv_len = LENGTH(IV);
+  ctx->cfb_num = 0;
+  ctx->gcm_used = 0;
+  memset(ctx->iv, 0, 16);
+  memcpy(ctx->iv, RAW(IV), ctx->iv_len < 16 ? ctx->iv_len : 16);
+  return R_NilValue;
+}
+
+/* the chaining state for the 16 byte IVs of CBC, CFB and CTR; any other
+   length can only be a GCM nonce, which is never changed */
+SEXP AESgetIV(SEXP context) {
+  aes_mode_context *ctx = _aes_get(context);
+  SEXP result = PROTECT(allocVector(RAWSXP, ctx->iv_len));
+
+  if (ctx->iv_len > 0)
+    memcpy(RAW(result), ctx->iv_len == 16 ? ctx->iv : ctx->iv_full, ctx->iv_len);
+  UNPROTECT(1);
+  return result;
+}
+
+/* PKCS#7 padding, if asked for, is added here and removed on decryption */
+SEXP AESencryptCBC(SEXP context, SEXP text, SEXP Padding) {
+  aes_mode_context *ctx = _aes_get_iv(context);
+  R_xlen_t len = XLENGTH(text);
+
+  if (TYPEOF(text) != RAWSXP)
+    error("Text must be a raw vector");				/* #nocov */
+  if (asLogical(Padding)) {
+    int pad = 16 - (int) (len % 16);
+    SEXP padded = PROTECT(allocVector(RAWSXP, len + pad));
+    memcpy(RAW(padded), RAW(text), len);
+    memset(RAW(padded) + len, pad, pad);
+    text = padded;
+    len += pad;
+  } else {
+    if (len % 16)
+      error("Text length must be a multiple of 16 bytes, or use `padding=TRUE`");
+    PROTECT(text = duplicate(text));
+  }
+
+  _aes_encrypt_cbc(ctx, ctx->iv, RAW(text), RAW(text), len / 16);
+  UNPROTECT(1);
+  return text;
+}
+
+SEXP AESdecryptCBC(SEXP context, SEXP ciphertext, SEXP Padding, SEXP Threads) {
+  aes_mode_context *ctx = _aes_get_iv(context);
+  R_xlen_t len = XLENGTH(ciphertext);
+  unsigned char iv[16];
+
+  if (len % 16)
+    error("Ciphertext length must be a multiple of 16 bytes");	/* #nocov */
+  PROTECT(ciphertext = _aes_copy(ciphertext, "Ciphertext"));
+
+  memcpy(iv, ctx->iv, 16);
+  _aes_threads(ctx, AES_DECRYPT_CBC, ctx->iv, RAW(ciphertext), len, asInteger(Threads));
+  if (asLogical(Padding) && len > 0) {
+    int pad = RAW(ciphertext)[len - 1];
+    int bad = pad < 1 || pad > 16;
+    for (int j = 1; !bad && j <= pad; j++)
+      bad = RAW(ciphertext)[len - j] != pad;
+    if (bad) {
+      /* leave the context as it was, so that the call can be retried */
+      memcpy(ctx->iv, iv, 16);
+      error("Invalid padding");
+    }
+    ciphertext = xlengthgets(ciphertext, len - pad);
+  }
+  UNPROTECT(1);
+  return ciphertext;
+}
+
+/* CFB with a full block of feedback; a partial block leaves the rest of
+   the register to be used by the next call */
+static void _aes_cfb_run(aes_mode_context *ctx, unsigned char *p, size_t len, int encrypt) {
+  int num = ctx->cfb_num;
+
+  for (size_t i = 0; i < len; i++) {
+    if (num == 0)
+      _aes_encrypt_block(ctx, ctx->iv, ctx->iv);
+    if (encrypt) {
+      p[i] ^= ctx->iv[num];
+      ctx->iv[num] = p[i];
+    } else {
+      unsigned char c = p[i];
+      p[i] ^= ctx->iv[num];
+      ctx->iv[num] = c;
+    }
+    num = (num + 1) & 15;
+  }
+  ctx->cfb_num = num;
+}
+
+static SEXP _aes_cfb(SEXP context, SEXP text, int encrypt) {
+  aes_mode_context *ctx = _aes_get_iv(context);
+
+  PROTECT(text = _aes_copy(text, encrypt ? "Text" : "Ciphertext"));
+  _aes_cfb_run(ctx, RAW(text), XLENGTH(text), encrypt);
+  UNPROTECT(1);
+  return text;
+}
+
+SEXP AESencryptCFB(SEXP context, SEXP text) {
+  return _aes_cfb(context, text, 1);
+}
+
+SEXP AESdecryptCFB(SEXP context, SEXP ciphertext) {
+  return _aes_cfb(context, ciphertext, 0);
+}
+
+/* CTR with the whole block as a big endian counter; every call starts a
+   new block, the rest of the keystream of a partial one is dropped */
+SEXP AEScryptCTR(SEXP context, SEXP text, SEXP Threads) {
+  aes_mode_context *ctx = _aes_get_iv(context);
+
+  PROTECT(text = _aes_copy(text, "Text"));
+  _aes_threads(ctx, AES_CTR, ctx->iv, RAW(text), XLENGTH(text), asInteger(Threads));
+  UNPROTECT(1);
+  return text;
+}
+
+/* GCM (NIST SP 800-38D) with a 128-bit tag, appended to the ciphertext.
+   Every call is a message of its own, encrypted and authenticated in one
+   pass over GCM_CHUNK bytes at a time. */
+#define GCM_CHUNK ((size_t) 1 << 16)
+
+/* the longest text SP 800-38D allows, 2^32 - 2 blocks, after which the
+   32-bit counter would come back to J0 and reuse keystream */
+#define GCM_MAX_LEN (((unsigned long long) 1 << 36) - 32)
+
+/* y = GHASH of y and data, the last block padded with zeros */
+static void _gcm_ghash(aes_mode_context *ctx, unsigned char y[16], const unsigned char *data,
+                       size_t len) {
+  ghash_update(&ctx->ghash, y, data, len / 16);
+  if (len % 16) {
+    unsigned char last[16] = {0};
+    memcpy(last, data + len - len % 16, len % 16);
+    ghash_update(&ctx->ghash, y, last, 1);
+  }
+}
+
+/* the counter only runs through its last 32 bits, as inc32() of SP
+   800-38D, so the 128-bit counter of the CTR code is used up to where
+   they wrap; texts are kept to GCM_MAX_LEN, so J0 is never reached */
+static void _gcm_ctr(aes_mode_context *ctx, unsigned char cb[16], unsigned char *buf, size_t len) {
   while (len > 0) {
-    aes_decrypt(ctx, block, block);
-    block += 16;
-    len -= 16;
+    unsigned long low = ((unsigned long) cb[12] << 24) | ((unsigned long) cb[13] << 16) |
+      ((unsigned long) cb[14] << 8) | cb[15];
+    unsigned long long room = 16 * ((1ULL << 32) - low);
+    size_t n = (unsigned long long) len < room ? len : (size_t) room;
+    unsigned char c[16];
+
+    memcpy(c, cb, 16);
+    _aes_ctr(ctx, c, buf, buf, n);
+    low = (low + (n + 15) / 16) & 0xffffffffUL;
+    for (int j = 15; j >= 12; j--, low >>= 8)
+      cb[j] = (unsigned char) low;
+    buf += n;
+    len -= n;
   }
-  return(ciphertext);
+}
+
+/* the pre-counter block J0 from the IV, which may be of any length */
+static aes_mode_context *_gcm_get(SEXP context, unsigned char j0[16]) {
+  aes_mode_context *ctx = _aes_get(context);
+
+  if (ctx->iv_len < 1)
+    error("GCM IV must not be empty");
+  memset(j0, 0, 16);
+  if (ctx->iv_len == 12) {
+    memcpy(j0, ctx->iv_full, 12);
+    j0[15] = 1;
+  } else {
+    unsigned char lengths[16] = {0};
+    unsigned long long bits = 8ULL * (unsigned long long) ctx->iv_len;
+    for (int j = 15; j >= 8; j--, bits >>= 8)
+      lengths[j] = (unsigned char) bits;
+    _gcm_ghash(ctx, j0, ctx->iv_full, ctx->iv_len);
+    ghash_update(&ctx->ghash, j0, lengths, 1);
+  }
+  return ctx;
+}
+
+static void _gcm_tag(aes_mode_context *ctx, const unsigned char j0[16], unsigned char y[16],
+                     size_t aad_len, size_t len, unsigned char tag[16]) {
+  unsigned char lengths[16];
+  unsigned long long a = 8ULL * aad_len, c = 8ULL * len;
+
+  for (int j = 7; j >= 0; j--, a >>= 8, c >>= 8) {
+    lengths[j] = (unsigned char) a;
+    lengths[8 + j] = (unsigned char) c;
+  }
+  ghash_update(&ctx->ghash, y, lengths, 1);
+  _aes_encrypt_block(ctx, j0, tag);
+  for (int j = 0; j < 16; j++) tag[j] ^= y[j];
+}
+
+SEXP AESencryptGCM(SEXP context, SEXP text, SEXP Aad) {
+  unsigned char j0[16], cb[16], y[16] = {0}, *p;
+  aes_mode_context *ctx = _gcm_get(context, j0);
+  R_xlen_t len = XLENGTH(text);
+  SEXP result;
+
+  if (TYPEOF(text) != RAWSXP)
+    error("Text must be a raw vector");				/* #nocov */
+  if (TYPEOF(Aad) != RAWSXP)
+    error("AAD must be a raw vector");				/* #nocov */
+  if ((unsigned long long) len > GCM_MAX_LEN)
+    error("GCM texts are limited to 2^36 - 32 bytes");
+  if (ctx->gcm_used)
+    error("A GCM IV can only be used for one message, use a new AES object");
+  ctx->gcm_used = 1;
+
+  result = PROTECT(allocVector(RAWSXP, len + 16));
+  p = RAW(result);
+  memcpy(p, RAW(text), len);
+  _gcm_ghash(ctx, y, RAW(Aad), XLENGTH(Aad));
+  memcpy(cb, j0, 16);
+  for (int j = 15; j >= 12 && ++cb[j] == 0; j--)
+    ;
+  for (R_xlen_t i = 0; i < len; i += GCM_CHUNK) {
+    size_t n = (size_t) (len - i) < GCM_CHUNK ? (size_t) (len - i) : GCM_CHUNK;
+    _gcm_ctr(ctx, cb, p + i, n);
+    _gcm_ghash(ctx, y, p + i, n);
+  }
+  _gcm_tag(ctx, j0, y, XLENGTH(Aad), len, p + len);
+  UNPROTECT(1);
+  return result;
+}
+
+/* the plaintext is only returned if the tag matches */
+SEXP AESdecryptGCM(SEXP context, SEXP ciphertext, SEXP Aad) {
+  unsigned char j0[16], cb[16], y[16] = {0}, tag[16], *p;
+  aes_mode_context *ctx = _gcm_get(context, j0);
+  R_xlen_t len = XLENGTH(ciphertext) - 16;
+  int diff = 0;
+  SEXP result;
+
+  if (TYPEOF(ciphertext) != RAWSXP)
+    error("Ciphertext must be a raw vector");			/* #nocov */
+  if (TYPEOF(Aad) != RAWSXP)
+    error("AAD must be a raw vector");				/* #nocov */
+  if (len < 0)
+    error("Ciphertext must include the 16 byte tag");
+  if ((unsigned long long) len > GCM_MAX_LEN)
+    error("GCM texts are limited to 2^36 - 32 bytes");
+
+  result = PROTECT(allocVector(RAWSXP, len));
+  p = RAW(result);
+  memcpy(p, RAW(ciphertext), len);
+  _gcm_ghash(ctx, y, RAW(Aad), XLENGTH(Aad));
+  memcpy(cb, j0, 16);
+  for (int j = 15; j >= 12 && ++cb[j] == 0; j--)
+    ;
+  for (R_xlen_t i = 0; i < len; i += GCM_CHUNK) {
+    size_t n = (size_t) (len - i) < GCM_CHUNK ? (size_t) (len - i) : GCM_CHUNK;
+    _gcm_ghash(ctx, y, p + i, n);
+    _gcm_ctr(ctx, cb, p + i, n);
+  }
+  _gcm_tag(ctx, j0, y, XLENGTH(Aad), len, tag);
+  for (int j = 0; j < 16; j++)
+    diff |= tag[j] ^ RAW(ciphertext)[len + j];
+  if (diff) {
+    memset(p, 0, len);
+    error("GCM authentication failed");
+  }
+  UNPROTECT(1);
+  return result;
+}
+
+/* AES() on files: the input is streamed through a buffer of
+   AES_FILE_CHUNK bytes, so that the memory used does not depend on the
+   size of the file, and the chaining state carries over as it does
+   between calls of encrypt() and decrypt() */
+#define AES_FILE_CHUNK ((size_t) 4 << 20)
+
+#define AES_FILE_OK       0
+#define AES_FILE_EWRITE   1
+#define AES_FILE_ELENGTH  2	/* not a whole number of blocks */
+#define AES_FILE_EPADDING 3
+#define AES_FILE_ETAG     4
+#define AES_FILE_ELIMIT   5	/* GCM: longer than GCM_MAX_LEN */
+
+typedef struct {
+  aes_mode_context *ctx;
+  int mode, encrypt, padding;
+  thread_pool *pool;		/* NULL to run serially */
+  aes_job *jobs;		/* one per thread of pool */
+  unsigned char *buf;		/* AES_FILE_CHUNK + 32 bytes */
+  size_t fill;
+  FILE *out;
+  digest_hasher *hasher;	/* NULL for no digest */
+  int hash_output;		/* of what is written, rather than what is read */
+  unsigned char j0[16], cb[16], y[16];	/* GCM */
+  size_t aad_len;
+  unsigned long long len;	/* GCM: bytes of text */
+  int status;
+} aes_file_state;
+
+static void _aes_file_write(aes_file_state *st, const unsigned char *p, size_t n) {
+  if (st->status != AES_FILE_OK) return;
+  if (st->hasher && st->hash_output) hasher_update(st->hasher, p, n);
+  if (n > 0 && fwrite(p, 1, n, st->out) != n) st->status = AES_FILE_EWRITE;
+}
+
+/* transforms the first n bytes of the buffer in place */
+static void _aes_file_process(aes_file_state *st, size_t n) {
+  aes_mode_context *ctx = st->ctx;
+  unsigned char *p = st->buf;
+
+  switch (st->mode) {
+  case 1:
+    _aes_threads_run(ctx, st->encrypt ? AES_ENCRYPT_ECB : AES_DECRYPT_ECB, NULL, p, n,
+                     st->pool, st->jobs);
+    break;
+  case 2:
+    if (st->encrypt) _aes_encrypt_cbc(ctx, ctx->iv, p, p, n / 16);
+    else _aes_threads_run(ctx, AES_DECRYPT_CBC, ctx->iv, p, n, st->pool, st->jobs);
+    break;
+  case 3:
+    _aes_cfb_run(ctx, p, n, st->encrypt);
+    break;
+  case 6:
+    _aes_threads_run(ctx, AES_CTR, ctx->iv, p, n, st->pool, st->jobs);
+    break;
+  case 8:
+    if (st->len + n > GCM_MAX_LEN) {	/* the file grew since it was checked */
+      st->status = AES_FILE_ELIMIT;
+      return;
+    }
+    if (!st->encrypt) _gcm_ghash(ctx, st->y, p, n);
+    _gcm_ctr(ctx, st->cb, p, n);
+    if (st->encrypt) _gcm_ghash(ctx, st->y, p, n);
+    st->len += n;
+    break;
+  }
+}
+
+/* the bytes at the end of the input that only the end of the file
+   decides about: the padded block, or the GCM tag */
+static size_t _aes_file_hold(const aes_file_state *st) {
+  return !st->encrypt && ((st->mode == 2 && st->padding) || st->mode == 8) ? 16 : 0;
+}
+
+/* all but the held back bytes go out once the buffer is full; as the
+   buffer holds AES_FILE_CHUNK + 16 bytes, whole blocks are processed */
+static void _aes_file_chunk(void *data, const unsigned char *buf, size_t len) {
+  aes_file_state *st = (aes_file_state *) data;
+
+  if (st->hasher && !st->hash_output) hasher_update(st->hasher, buf, len);
+  while (len > 0 && st->status == AES_FILE_OK) {
+    size_t k = AES_FILE_CHUNK + 16 - st->fill;
+    if (k > len) k = len;
+    memcpy(st->buf + st->fill, buf, k);
+    st->fill += k;
+    buf += k;
+    len -= k;
+    if (st->fill == AES_FILE_CHUNK + 16) {
+      size_t n = (st->fill - _aes_file_hold(st)) & ~(size_t) 15;
+      _aes_file_process(st, n);
+      _aes_file_write(st, st->buf, n);
+      memmove(st->buf, st->buf + n, st->fill - n);
+      st->fill -= n;
+    }
+  }
+}
+
+static void _aes_file_finish(aes_file_state *st) {
+  size_t n = st->fill;
+  unsigned char tag[16];
+
+  if (st->status != AES_FILE_OK) return;
+  if (st->encrypt) {
+    if (st->mode == 2 && st->padding) {
+      int pad = 16 - (int) (n % 16);
+      memset(st->buf + n, pad, pad);
+      n += pad;
+    }
+    if ((st->mode == 1 || st->mode == 2) && n % 16) {
+      st->status = AES_FILE_ELENGTH;
+      return;
+    }
+    _aes_file_process(st, n);
+    _aes_file_write(st, st->buf, n);
+    if (st->mode == 8) {
+      _gcm_tag(st->ctx, st->j0, st->y, st->aad_len, st->len, tag);
+      _aes_file_write(st, tag, 16);
+    }
+    return;
+  }
+
+  if (((st->mode == 1 || st->mode == 2) && n % 16) || n < _aes_file_hold(st)) {
+    st->status = st->mode == 8 ? AES_FILE_ETAG : AES_FILE_ELENGTH;
+    return;
+  }
+  if (st->mode == 8) {
+    int diff = 0;
+    n -= 16;
+    _aes_file_process(st, n);
+    if (st->status != AES_FILE_OK) return;
+    _gcm_tag(st->ctx, st->j0, st->y, st->aad_len, st->len, tag);
+    for (int j = 0; j < 16; j++)
+      diff |= tag[j] ^ st->buf[n + j];
+    if (diff) {
+      st->status = AES_FILE_ETAG;
+      return;
+    }
+  } else {
+    _aes_file_process(st, n);
+  }
+  if (st->mode == 2 && st->padding) {
+    int pad = st->buf[n - 1], bad = pad < 1 || pad > 16;
+    for (int j = 1; !bad && j <= pad; j++)
+      bad = st->buf[n - j] != pad;
+    if (bad) {
+      st->status = AES_FILE_EPADDING;
+      return;
+    }
+    n -= pad;
+  }
+  _aes_file_write(st, st->buf, n);
+}
+
+/* encrypts or decrypts the file In into Out, in the mode of the AES()
+   object; returns the digest of the input or output if Algo is given */
+SEXP AEScryptFile(SEXP context, SEXP Mode, SEXP Encrypt, SEXP In, SEXP Out, SEXP Padding,
+                  SEXP Aad, SEXP Algo, SEXP Hash_output, SEXP Threads) {
+  aes_file_state st;
+  file_reader_stat_t in_stat;
+  digest_hasher hasher;
+  unsigned char hash[HASHER_MAX_OUTPUT], iv[16];
+  const char *out_path = CHAR(STRING_ELT(Out, 0));
+  char *tmp_path;
+  int output_length = 0, status, cfb_num, threads = asInteger(Threads);
+
+  memset(&st, 0, sizeof(st));
+  st.mode = asInteger(Mode);
+  st.encrypt = asLogical(Encrypt);
+  st.padding = asLogical(Padding);
+  st.hash_output = asLogical(Hash_output);
+  if (TYPEOF(In) != STRSXP || TYPEOF(Out) != STRSXP || TYPEOF(Aad) != RAWSXP)
+    error("Invalid arguments");					/* #nocov */
+
+  /* nothing is created or truncated for an input that cannot be opened or
+     is too long for GCM, nor is the object used up; pipes and devices show
+     no size here, and GCM checks them again as they are read */
+  _digest_file_options();
+  if (file_reader_stat(CHAR(STRING_ELT(In, 0)), &in_stat) != FILE_READER_OK)
+    error("Cannot open input file: %s", CHAR(STRING_ELT(In, 0)));
+  if (st.mode == 8 && in_stat.size - (st.encrypt ? 0 : 16) > (int64_t) GCM_MAX_LEN)
+    error("GCM texts are limited to 2^36 - 32 bytes");
+  if (st.mode == 1) {
+    st.ctx = _aes_get(context);
+  } else if (st.mode == 8) {
+    st.ctx = _gcm_get(context, st.j0);
+    if (st.encrypt && st.ctx->gcm_used)
+      error("A GCM IV can only be used for one message, use a new AES object");
+    memcpy(st.cb, st.j0, 16);
+    for (int j = 15; j >= 12 && ++st.cb[j] == 0; j--)
+      ;
+    st.aad_len = XLENGTH(Aad);
+    _gcm_ghash(st.ctx, st.y, RAW(Aad), st.aad_len);
+  } else {
+    st.ctx = _aes_get_iv(context);
+  }
+  /* blocks are checked here, before the chaining state moves on; pipes
+     and devices are only checked at their end */
+  if ((st.mode == 1 || (st.mode == 2 && !(st.encrypt && st.padding))) && in_stat.size % 16)
+    error("File length must be a multiple of 16 bytes%s",
+          st.mode == 2 && st.encrypt ? ", or use `padding=TRUE`" : "");
+  if (asInteger(Algo) != NA_INTEGER) {
+    output_length = hasher_init(&hasher, asInteger(Algo), 0);
+    if (output_length < 0)
+      error("Unsupported algorithm code"); /* should not be reached due to test in R */ /* #nocov */
+    st.hasher = &hasher;
+  }
+  st.buf = (unsigned char *) R_alloc(AES_FILE_CHUNK + 32, 1);
+  if (threads >= 2)
+    st.jobs = (aes_job *) R_alloc(threads, sizeof(*st.jobs));
+
+  /* the output goes to a new file, which only replaces Out once it is
+     complete and authenticated; on failure Out is left as it was, and so
+     is the chaining state of the object */
+  tmp_path = R_alloc(strlen(out_path) + 32, 1);
+  st.out = file_writer_open_temp(out_path, tmp_path, strlen(out_path) + 32);
+  if (st.out == NULL)
+    error("Cannot open output file: %s", out_path);
+  /* only now is the IV used up, as a ciphertext may be written under it */
+  if (st.mode == 8)
+    st.ctx->gcm_used |= st.encrypt;
+  memcpy(iv, st.ctx->iv, 16);
+  cfb_num = st.ctx->cfb_num;
+  /* one pool serves every chunk; pipes and devices show no size */
+  if (st.jobs != NULL && (st.mode == 1 || st.mode == 6 || (st.mode == 2 && !st.encrypt)) &&
+      (in_stat.size >= (int64_t) AES_THREADS_MIN_LEN || in_stat.size == 0))
+    st.pool = thread_pool_create(threads);
+  status = file_reader_run(CHAR(STRING_ELT(In, 0)), 0, -1, 0, _aes_file_chunk, &st);
+  if (st.pool != NULL)
+    thread_pool_destroy(st.pool);
+  if (status == FILE_READER_OK)
+    _aes_file_finish(&st);
+  if (fclose(st.out) != 0 && st.status == AES_FILE_OK)
+    st.status = AES_FILE_EWRITE;
+  if (status == FILE_READER_OK && st.status == AES_FILE_OK &&
+      file_writer_commit(tmp_path, out_path) != 0)
+    st.status = AES_FILE_EWRITE;
+  if (status != FILE_READER_OK || st.status != AES_FILE_OK) {
+    file_writer_remove(tmp_path);
+    memcpy(st.ctx->iv, iv, 16);
+    st.ctx->cfb_num = cfb_num;
+  }
+
+  switch (status) {
+  case FILE_READER_EOPEN:
+    error("Cannot open input file: %s", CHAR(STRING_ELT(In, 0)));	/* #nocov */
+  case FILE_READER_EREAD:
+    error("Cannot read input file: %s", CHAR(STRING_ELT(In, 0)));	/* #nocov */
+  }
+  switch (st.status) {
+  case AES_FILE_EWRITE:
+    error("Cannot write output file: %s", out_path);		/* #nocov */
+  case AES_FILE_ELENGTH:
+    error("File length must be a multiple of 16 bytes%s",
+          st.mode == 2 && st.encrypt ? ", or use `padding=TRUE`" : "");
+  case AES_FILE_EPADDING:
+    error("Invalid padding");
+  case AES_FILE_ETAG:
+    error("GCM authentication failed");
+  case AES_FILE_ELIMIT:
+    error("GCM texts are limited to 2^36 - 32 bytes");		/* #nocov */
+  }
+  if (st.hasher == NULL)
+    return R_NilValue;
+  hasher_final(&hasher, hash);
+  return _digest_result(hash, output_length, 0);
 }
@@ -0,0 +1,206 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* Incremental hashing from R, in the manner of the AES context in raes.c:
+   the hasher lives in an external pointer, is fed with hasherUpdate() and
+   read out with hasherFinalize(), which works on a copy so that more data
+   can follow. The digests are the same as those of digest(serialize=FALSE)
+   over the concatenated input. HMAC keys are held the same way, as the
+   pair of hashers having absorbed the inner and the outer padded key. */
+
+#include <stdint.h>
+#include <string.h>
+
+#include <R.h>
+#include <Rinternals.h>
+
+#include "digest.h"
+#include "hasher.h"
+
+/* the xxh3 state asks for 64 byte alignment, more than R_Calloc() promises */
+#define HASHER_ALIGN 64
+
+typedef struct {
+    void *block;                /* as returned by R_Calloc(), for R_Free() */
+    int output_length;
+    digest_hasher *hasher;      /* inside block, suitably aligned; two for HMAC */
+} hasher_object;
+
+static void HasherFinalizer(SEXP ptr) {
+    hasher_object *obj = R_ExternalPtrAddr(ptr);
+    if (!obj) return;
+    R_Free(obj->block);
+    R_Free(obj);
+    R_ClearExternalPtr(ptr);
+}
+
+static SEXP _hasher_wrap(const digest_hasher *state, const int count, const int output_length,
+                         const char *tag) {
+    hasher_object *obj = R_Calloc(1, hasher_object);
+    obj->block = R_Calloc(count * sizeof(digest_hasher) + HASHER_ALIGN, char);
+    obj->hasher = (digest_hasher *) (((uintptr_t) obj->block + HASHER_ALIGN - 1) &
+                                     ~(uintptr_t) (HASHER_ALIGN - 1));
+    obj->output_length = output_length;
+    if (state != NULL) memcpy(obj->hasher, state, count * sizeof(digest_hasher));
+
+    SEXP result = PROTECT(R_MakeExternalPtr(obj, install(tag), R_NilValue));
+    R_RegisterCFinalizerEx(result, HasherFinalizer, TRUE);
+    UNPROTECT(1);
+    return result;
+}
+
+static hasher_object *_hasher_get(SEXP context, const char *tag) {
+    if (TYPEOF(context) != EXTPTRSXP || R_ExternalPtrTag(context) != install(tag))
+        error("Not a %s context", tag);                         /* #nocov */
+    hasher_object *obj = R_ExternalPtrAddr(context);
+    if (!obj)
+        error("Hasher context not initialized");                /* #nocov */
+    return obj;
+}
+
+SEXP hasherInit(SEXP Algo, SEXP Seed) {
+    SEXP result = PROTECT(_hasher_wrap(NULL, 1, 0, "digest_hasher"));
+    hasher_object *obj = R_ExternalPtrAddr(result);
+
+    obj->output_length = hasher_init(obj->hasher, asInteger(Algo), (uint32_t) asInteger(Seed));
+    if (obj->output_length < 0)
+        error("Unsupported algorithm code");                    /* #nocov */
+    UNPROTECT(1);
+    return result;
+}
+
+/* raw vectors are hashed as they are, character vectors as the bytes of
+   their elements one after the other */
+SEXP hasherUpdate(SEXP context, SEXP data) {
+    hasher_object *obj = _hasher_get(context, "digest_hasher");
+
+    if (TYPEOF(data) == RAWSXP) {
+        hasher_update(obj->hasher, RAW(data), (size_t) XLENGTH(data));
+    } else if (TYPEOF(data) == STRSXP) {
+        for (R_xlen_t i = 0; i < XLENGTH(data); i++) {
+            SEXP elt = STRING_ELT(data, i);
+            if (elt == NA_STRING)
+                error("Cannot hash a missing value");
+            hasher_update(obj->hasher, (const unsigned char *) CHAR(elt), (size_t) LENGTH(elt));
+        }
+    } else {
+        error("Data must be a raw or character vector");
+    }
+    return R_NilValue;
+}
+
+SEXP hasherFinalize(SEXP context, SEXP Raw) {
+    hasher_object *obj = _hasher_get(context, "digest_hasher");
+    digest_hasher state;
+    unsigned char hash[HASHER_MAX_OUTPUT];
+
+    memcpy(&state, obj->hasher, sizeof(digest_hasher));
+    hasher_final(&state, hash);
+    return _digest_result(hash, obj->output_length, asLogical(Raw) == TRUE);
+}
+
+SEXP hasherCopy(SEXP context) {
+    hasher_object *obj = _hasher_get(context, "digest_hasher");
+    return _hasher_wrap(obj->hasher, 1, obj->output_length, "digest_hasher");
+}
+
+/* HMAC (RFC 2104) pads keys to the block size of the hash function, or
+   hashes them first if longer; crc32 keeps the four byte blocks which
+   hmac() has always used for it */
+static int _hmac_block_size(const int algo) {
+    switch (algo) {
+    case 1: case 2: case 4: return 64;      /* md5, sha1, sha256 */
+    case 3: return 4;                       /* crc32 */
+    case 5: return 128;                     /* sha512 */
+    default: return -1;
+    }
+}
+
+SEXP hmacInit(SEXP Key, SEXP Algo) {
+    int algo = asInteger(Algo), block_size = _hmac_block_size(algo);
+    unsigned char key[128], pad[128];
+    digest_hasher state[2];
+
+    if (block_size < 0)
+        error("Unsupported algorithm code");                    /* #nocov */
+    if (TYPEOF(Key) != RAWSXP)
+        error("Key must be a raw vector");                      /* #nocov */
+    int output_length = hasher_init(&state[0], algo, 0);
+    size_t key_length = (size_t) XLENGTH(Key);
+    memset(key, 0, sizeof(key));
+    if (key_length > (size_t) block_size) {
+        hasher_update(&state[0], RAW(Key), key_length);
+        hasher_final(&state[0], key);
+        hasher_init(&state[0], algo, 0);
+    } else if (key_length > 0) {
+        memcpy(key, RAW(Key), key_length);
+    }
+    hasher_init(&state[1], algo, 0);
+    for (int i = 0; i < block_size; i++) pad[i] = key[i] ^ 0x36;
+    hasher_update(&state[0], pad, block_size);
+    for (int i = 0; i < block_size; i++) pad[i] = key[i] ^ 0x5c;
+    hasher_update(&state[1], pad, block_size);
+    memset(key, 0, sizeof(key));
+    memset(pad, 0, sizeof(pad));
+
+    return _hasher_wrap(state, 2, output_length, "digest_hmac");
+}
+
+/* each message only costs finishing the two prepared hashers: a raw
+   vector is one message, a character vector one per element */
+SEXP hmacSign(SEXP context, SEXP Messages, SEXP Output) {
+    hasher_object *obj = _hasher_get(context, "digest_hmac");
+    int output = asInteger(Output);
+    unsigned char hash[HASHER_MAX_OUTPUT];
+    digest_hasher state;
+    R_xlen_t n;
+
+    if (TYPEOF(Messages) == RAWSXP) n = 1;
+    else if (TYPEOF(Messages) == STRSXP) n = XLENGTH(Messages);
+    else error("Messages must be a raw or character vector");
+
+    SEXP ans = PROTECT(_vdigest_alloc(n, obj->output_length, output));
+    for (R_xlen_t i = 0; i < n; i++) {
+        const unsigned char *msg;
+        size_t len;
+        if (TYPEOF(Messages) == RAWSXP) {
+            msg = RAW(Messages);
+            len = (size_t) XLENGTH(Messages);
+        } else {
+            SEXP elt = STRING_ELT(Messages, i);
+            if (elt == NA_STRING)
+                error("Cannot sign a missing value");
+            msg = (const unsigned char *) CHAR(elt);
+            len = (size_t) LENGTH(elt);
+        }
+        memcpy(&state, &obj->hasher[0], sizeof(digest_hasher));
+        hasher_update(&state, msg, len);
+        hasher_final(&state, hash);
+        memcpy(&state, &obj->hasher[1], sizeof(digest_hasher));
+        hasher_update(&state, hash, obj->output_length);
+        hasher_final(&state, hash);
+        _vdigest_store(ans, i, hash, obj->output_length, output);
+    }
+    UNPROTECT(1);
+    return ans;
+}
@@ -0,0 +1,143 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <string.h>
+
+#include "rolling.h"
+
+static uint64_t _splitmix64(uint64_t *state) {
+    uint64_t z = (*state += UINT64_C(0x9E3779B97F4A7C15));
+    z = (z ^ (z >> 30)) * UINT64_C(0xBF58476D1CE4E5B9);
+    z = (z ^ (z >> 27)) * UINT64_C(0x94D049BB133111EB);
+    return z ^ (z >> 31);
+}
+
+int rolling_init(rolling_hasher *r, int algo, int bits, size_t width, uint64_t seed) {
+    uint64_t state = seed;
+
+    if ((algo != ROLLING_BUZHASH && algo != ROLLING_RABIN_KARP) ||
+        (bits != 32 && bits != 64) || width == 0)
+        return -1;
+    r->algo = algo;
+    r->bits = bits;
+    r->width = width;
+    for (int i = 0; i < 256; i++) {
+        r->table[i] = _splitmix64(&state);
+        if (bits == 32) r->table[i] &= UINT64_C(0xFFFFFFFF);
+    }
+    r->base = _splitmix64(&state) | 1;
+    r->base_w = 1;
+    for (size_t i = 1; i < width; i++) r->base_w *= r->base;
+    if (bits == 32) {
+        r->base &= UINT64_C(0xFFFFFFFF);
+        r->base_w &= UINT64_C(0xFFFFFFFF);
+    }
+    return 0;
+}
+
+static inline uint32_t _rotl32(uint32_t x, unsigned int k) {
+    k &= 31;
+    return k ? (x << k) | (x >> (32 - k)) : x;
+}
+
+static inline uint64_t _rotl64(uint64_t x, unsigned int k) {
+    k &= 63;
+    return k ? (x << k) | (x >> (64 - k)) : x;
+}
+
+static inline void _store64(double *out, uint64_t h) {
+    memcpy(out, &h, sizeof(h));
+}
+
+/* the four variants are spelled out so each inner loop works on its own
+   word size without branches */
+
+static void _buzhash32(const rolling_hasher *r, const unsigned char *p, size_t count,
+                       double *out) {
+    const size_t w = r->width;
+    uint32_t t[256], h = 0;
+
+    for (int i = 0; i < 256; i++) t[i] = (uint32_t) r->table[i];
+    for (size_t i = 0; i < w; i++) h = _rotl32(h, 1) ^ t[p[i]];
+    out[0] = (double) h;
+    for (size_t i = 1; i < count; i++) {
+        h = _rotl32(h, 1) ^ _rotl32(t[p[i - 1]], (unsigned int) w) ^ t[p[i + w - 1]];
+        out[i] = (double) h;
+    }
+}
+
+static void _buzhash64(const rolling_hasher *r, const unsigned char *p, size_t count,
+                       double *out) {
+    const size_t w = r->width;
+    const uint64_t *t = r->table;
+    uint64_t h = 0;
+
+    for (size_t i = 0; i < w; i++) h = _rotl64(h, 1) ^ t[p[i]];
+    _store64(out, h);
+    for (size_t i = 1; i < count; i++) {
+        h = _rotl64(h, 1) ^ _rotl64(t[p[i - 1]], (unsigned int) w) ^ t[p[i + w - 1]];
+        _store64(out + i, h);
+    }
+}
+
+static void _rabin_karp32(const rolling_hasher *r, const unsigned char *p, size_t count,
+                          double *out) {
+    const size_t w = r->width;
+    const uint32_t b = (uint32_t) r->base, bw = (uint32_t) r->base_w;
+    uint32_t t[256], h = 0;
+
+    for (int i = 0; i < 256; i++) t[i] = (uint32_t) r->table[i];
+    for (size_t i = 0; i < w; i++) h = h * b + t[p[i]];
+    out[0] = (double) h;
+    for (size_t i = 1; i < count; i++) {
+        h = (h - t[p[i - 1]] * bw) * b + t[p[i + w - 1]];
+        out[i] = (double) h;
+    }
+}
+
+static void _rabin_karp64(const rolling_hasher *r, const unsigned char *p, size_t count,
+                          double *out) {
+    const size_t w = r->width;
+    const uint64_t b = r->base, bw = r->base_w, *t = r->table;
+    uint64_t h = 0;
+
+    for (size_t i = 0; i < w; i++) h = h * b + t[p[i]];
+    _store64(out, h);
+    for (size_t i = 1; i < count; i++) {
+        h = (h - t[p[i - 1]] * bw) * b + t[p[i + w - 1]];
+        _store64(out + i, h);
+    }
+}
+
+void rolling_run(const rolling_hasher *r, const unsigned char *buf, size_t first,
+                 size_t count, double *out) {
+    if (count == 0) return;
+    buf += first;
+    if (r->algo == ROLLING_BUZHASH) {
+        if (r->bits == 32) _buzhash32(r, buf, count, out);
+        else _buzhash64(r, buf, count, out);
+    } else {
+        if (r->bits == 32) _rabin_karp32(r, buf, count, out);
+        else _rabin_karp64(r, buf, count, out);
+    }
+}
@@ -0,0 +1,56 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _ROLLING_H
+#define _ROLLING_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define ROLLING_BUZHASH    1
+#define ROLLING_RABIN_KARP 2
+
+/* Hashes of all windows of a fixed width, each computed from the previous
+   one in constant time. Buzhash (cyclic polynomial) rotates and xors a
+   table value per byte; Rabin-Karp evaluates a polynomial in a random odd
+   base modulo 2^bits, also over table values. Table and base follow from
+   the seed. No R API is used. */
+typedef struct {
+    int algo, bits;
+    size_t width;
+    uint64_t table[256];
+    uint64_t base, base_w;      /* Rabin-Karp: base and base^(width - 1) */
+} rolling_hasher;
+
+/* returns 0, or -1 for an unknown algorithm, bits other than 32 or 64,
+   or a zero width */
+int rolling_init(rolling_hasher *r, int algo, int bits, size_t width, uint64_t seed);
+
+/* hashes the count windows of buf starting at offsets first, first + 1,
+   ...; buf must hold first + count + width - 1 bytes. 32-bit hashes are
+   stored as their (exact) values, 64-bit ones as the bits of the double,
+   as for integer64 */
+void rolling_run(const rolling_hasher *r, const unsigned char *buf, size_t first,
+                 size_t count, double *out);
+
+#endif /* _ROLLING_H */
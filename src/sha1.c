@@ -7,6 +7,7 @@
 #include <string.h>
 
 #include "sha1.h"
+#include "sha_ni.h"
 
 #define GET_UINT32(n,b,i)                       \
 {                                               \
@@ -192,6 +193,33 @@ void sha1_process( sha1_context *ctx, uint8 data[64] )
     ctx->state[4] += E;
 }
 
+/*
+ * digest: runs of whole blocks go to the SHA-NI kernel when the CPU has
+ * the SHA extensions, and through sha1_process() otherwise
+ */
+static void sha1_process_blocks( sha1_context *ctx, uint8 *data, uint32 nblocks )
+{
+#if DIGEST_X86_SIMD
+    if( sha_ni_available() )
+    {
+        uint32_t state[5];
+        int i;
+
+        for( i = 0; i < 5; i++ )
+            state[i] = (uint32_t) ctx->state[i];
+        sha1_process_blocks_shani( state, data, nblocks );
+        for( i = 0; i < 5; i++ )
+            ctx->state[i] = state[i];
+        return;
+    }
+#endif
+    while( nblocks-- )
+    {
+        sha1_process( ctx, data );
+        data += 64;
+    }
+}
+
 void sha1_update( sha1_context *ctx, uint8 *input, uint32 length )
 {
     uint32 left, fill;
@@ -211,17 +239,17 @@ void sha1_update( sha1_context *ctx, uint8 *input, uint32 length )
     {
         memcpy( (void *) (ctx->buffer + left),
                 (void *) input, fill );
-        sha1_process( ctx, ctx->buffer );
+        sha1_process_blocks( ctx, ctx->buffer, 1 );
         length -= fill;
         input  += fill;
         left = 0;
     }
 
-    while( length >= 64 )
+    if( length >= 64 )
     {
-        sha1_process( ctx, input );
-        length -= 64;
-        input  += 64;
+        sha1_process_blocks( ctx, input, length >> 6 );
+        input  += length & ~0x3F;
+        length &= 0x3F;
     }
 
     if( length )
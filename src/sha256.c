@@ -21,6 +21,7 @@
 #include <string.h>
 
 #include "sha256.h"
+#include "sha_ni.h"
 
 #define GET_UINT32(n,b,i)                       \
 {                                               \
@@ -184,6 +185,33 @@ void sha256_process( sha256_context *ctx, uint8 data[64] )
     ctx->state[7] += H;
 }
 
+/*
+ * digest: runs of whole blocks go to the SHA-NI kernel when the CPU has
+ * the SHA extensions, and through sha256_process() otherwise
+ */
+static void sha256_process_blocks( sha256_context *ctx, uint8 *data, uint32 nblocks )
+{
+#if DIGEST_X86_SIMD
+    if( sha_ni_available() )
+    {
+        uint32_t state[8];
+        int i;
+
+        for( i = 0; i < 8; i++ )
+            state[i] = (uint32_t) ctx->state[i];
+        sha256_process_blocks_shani( state, data, nblocks );
+        for( i = 0; i < 8; i++ )
+            ctx->state[i] = state[i];
+        return;
+    }
+#endif
+    while( nblocks-- )
+    {
+        sha256_process( ctx, data );
+        data += 64;
+    }
+}
+
 void sha256_update( sha256_context *ctx, uint8 *input, uint32 length )
 {
     uint32 left, fill;
@@ -203,17 +231,17 @@ void sha256_update( sha256_context *ctx, uint8 *input, uint32 length )
     {
         memcpy( (void *) (ctx->buffer + left),
                 (void *) input, fill );
-        sha256_process( ctx, ctx->buffer );
+        sha256_process_blocks( ctx, ctx->buffer, 1 );
         length -= fill;
         input  += fill;
         left = 0;
     }
 
-    while( length >= 64 )
+    if( length >= 64 )
     {
-        sha256_process( ctx, input );
-        length -= 64;
-        input  += 64;
+        sha256_process_blocks( ctx, input, length >> 6 );
+        input  += length & ~0x3F;
+        length &= 0x3F;
     }
 
     if( length )
@@ -0,0 +1,403 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/* SHA-1 and SHA-256 compression using the x86 SHA extensions, after the
+   sample code in Intel's "New Instructions Supporting the Secure Hash
+   Algorithm on Intel Architecture Processors" (2013). In a file of its own
+   so that the instructions can be enabled for it alone; sha1.c and
+   sha256.c only call it after checking the CPU, and fall back to their
+   own round functions otherwise. */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "sha_ni.h"
+
+#if DIGEST_X86_SIMD
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <immintrin.h>
+#endif
+
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sha,sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC push_options
+#pragma GCC target("sha,sse4.1")
+#endif
+
+void sha1_process_blocks_shani(uint32_t state[5], const unsigned char *data, size_t nblocks) {
+    const __m128i mask = _mm_set_epi64x(0x0001020304050607ULL, 0x08090a0b0c0d0e0fULL);
+    __m128i abcd, abcd_save, e0, e0_save, e1;
+    __m128i msg0, msg1, msg2, msg3;
+
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) state), 0x1B);
+    e0 = _mm_set_epi32((int) state[4], 0, 0, 0);
+
+    while (nblocks--) {
+        abcd_save = abcd;
+        e0_save = e0;
+
+        /* rounds 0-3 */
+        msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 0)), mask);
+        e0 = _mm_add_epi32(e0, msg0);
+        e1 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+
+        /* rounds 4-7 */
+        msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), mask);
+        e1 = _mm_sha1nexte_epu32(e1, msg1);
+        e0 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+        msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+
+        /* rounds 8-11 */
+        msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), mask);
+        e0 = _mm_sha1nexte_epu32(e0, msg2);
+        e1 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+        msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+        msg0 = _mm_xor_si128(msg0, msg2);
+
+        /* rounds 12-15 */
+        msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), mask);
+        e1 = _mm_sha1nexte_epu32(e1, msg3);
+        e0 = abcd;
+        msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, 0);
+        msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+        msg1 = _mm_xor_si128(msg1, msg3);
+
+        /* rounds 16-19 */
+        e0 = _mm_sha1nexte_epu32(e0, msg0);
+        e1 = abcd;
+        msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 0);
+        msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+        msg2 = _mm_xor_si128(msg2, msg0);
+
+        /* rounds 20-23 */
+        e1 = _mm_sha1nexte_epu32(e1, msg1);
+        e0 = abcd;
+        msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+        msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+        msg3 = _mm_xor_si128(msg3, msg1);
+
+        /* rounds 24-27 */
+        e0 = _mm_sha1nexte_epu32(e0, msg2);
+        e1 = abcd;
+        msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+        msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+        msg0 = _mm_xor_si128(msg0, msg2);
+
+        /* rounds 28-31 */
+        e1 = _mm_sha1nexte_epu32(e1, msg3);
+        e0 = abcd;
+        msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+        msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+        msg1 = _mm_xor_si128(msg1, msg3);
+
+        /* rounds 32-35 */
+        e0 = _mm_sha1nexte_epu32(e0, msg0);
+        e1 = abcd;
+        msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 1);
+        msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+        msg2 = _mm_xor_si128(msg2, msg0);
+
+        /* rounds 36-39 */
+        e1 = _mm_sha1nexte_epu32(e1, msg1);
+        e0 = abcd;
+        msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, 1);
+        msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+        msg3 = _mm_xor_si128(msg3, msg1);
+
+        /* rounds 40-43 */
+        e0 = _mm_sha1nexte_epu32(e0, msg2);
+        e1 = abcd;
+        msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+        msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+        msg0 = _mm_xor_si128(msg0, msg2);
+
+        /* rounds 44-47 */
+        e1 = _mm_sha1nexte_epu32(e1, msg3);
+        e0 = abcd;
+        msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+        msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+        msg1 = _mm_xor_si128(msg1, msg3);
+
+        /* rounds 48-51 */
+        e0 = _mm_sha1nexte_epu32(e0, msg0);
+        e1 = abcd;
+        msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+        msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+        msg2 = _mm_xor_si128(msg2, msg0);
+
+        /* rounds 52-55 */
+        e1 = _mm_sha1nexte_epu32(e1, msg1);
+        e0 = abcd;
+        msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, 2);
+        msg0 = _mm_sha1msg1_epu32(msg0, msg1);
+        msg3 = _mm_xor_si128(msg3, msg1);
+
+        /* rounds 56-59 */
+        e0 = _mm_sha1nexte_epu32(e0, msg2);
+        e1 = abcd;
+        msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 2);
+        msg1 = _mm_sha1msg1_epu32(msg1, msg2);
+        msg0 = _mm_xor_si128(msg0, msg2);
+
+        /* rounds 60-63 */
+        e1 = _mm_sha1nexte_epu32(e1, msg3);
+        e0 = abcd;
+        msg0 = _mm_sha1msg2_epu32(msg0, msg3);
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+        msg2 = _mm_sha1msg1_epu32(msg2, msg3);
+        msg1 = _mm_xor_si128(msg1, msg3);
+
+        /* rounds 64-67 */
+        e0 = _mm_sha1nexte_epu32(e0, msg0);
+        e1 = abcd;
+        msg1 = _mm_sha1msg2_epu32(msg1, msg0);
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+        msg3 = _mm_sha1msg1_epu32(msg3, msg0);
+        msg2 = _mm_xor_si128(msg2, msg0);
+
+        /* rounds 68-71 */
+        e1 = _mm_sha1nexte_epu32(e1, msg1);
+        e0 = abcd;
+        msg2 = _mm_sha1msg2_epu32(msg2, msg1);
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+        msg3 = _mm_xor_si128(msg3, msg1);
+
+        /* rounds 72-75 */
+        e0 = _mm_sha1nexte_epu32(e0, msg2);
+        e1 = abcd;
+        msg3 = _mm_sha1msg2_epu32(msg3, msg2);
+        abcd = _mm_sha1rnds4_epu32(abcd, e0, 3);
+
+        /* rounds 76-79 */
+        e1 = _mm_sha1nexte_epu32(e1, msg3);
+        e0 = abcd;
+        abcd = _mm_sha1rnds4_epu32(abcd, e1, 3);
+
+        e0 = _mm_sha1nexte_epu32(e0, e0_save);
+        abcd = _mm_add_epi32(abcd, abcd_save);
+        data += 64;
+    }
+
+    _mm_storeu_si128((__m128i *) state, _mm_shuffle_epi32(abcd, 0x1B));
+    state[4] = (uint32_t) _mm_extract_epi32(e0, 3);
+}
+
+void sha256_process_blocks_shani(uint32_t state[8], const unsigned char *data, size_t nblocks) {
+    const __m128i mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+    __m128i state0, state1, abef_save, cdgh_save, msg, tmp;
+    __m128i msg0, msg1, msg2, msg3;
+
+    /* the rounds work on the state as (A, B, E, F) and (C, D, G, H) */
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[0]), 0xB1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *) &state[4]), 0x1B);
+    state0 = _mm_alignr_epi8(tmp, state1, 8);
+    state1 = _mm_blend_epi16(state1, tmp, 0xF0);
+
+    while (nblocks--) {
+        abef_save = state0;
+        cdgh_save = state1;
+
+        /* rounds 0-3 */
+        msg0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 0)), mask);
+        msg = _mm_add_epi32(msg0, _mm_set_epi64x(0xe9b5dba5b5c0fbcfULL, 0x71374491428a2f98ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+        /* rounds 4-7 */
+        msg1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 16)), mask);
+        msg = _mm_add_epi32(msg1, _mm_set_epi64x(0xab1c5ed5923f82a4ULL, 0x59f111f13956c25bULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+        /* rounds 8-11 */
+        msg2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 32)), mask);
+        msg = _mm_add_epi32(msg2, _mm_set_epi64x(0x550c7dc3243185beULL, 0x12835b01d807aa98ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+        /* rounds 12-15 */
+        msg3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *) (data + 48)), mask);
+        msg = _mm_add_epi32(msg3, _mm_set_epi64x(0xc19bf1749bdc06a7ULL, 0x80deb1fe72be5d74ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg0 = _mm_add_epi32(msg0, _mm_alignr_epi8(msg3, msg2, 4));
+        msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+        /* rounds 16-19 */
+        msg = _mm_add_epi32(msg0, _mm_set_epi64x(0x240ca1cc0fc19dc6ULL, 0xefbe4786e49b69c1ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg1 = _mm_add_epi32(msg1, _mm_alignr_epi8(msg0, msg3, 4));
+        msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+        /* rounds 20-23 */
+        msg = _mm_add_epi32(msg1, _mm_set_epi64x(0x76f988da5cb0a9dcULL, 0x4a7484aa2de92c6fULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg2 = _mm_add_epi32(msg2, _mm_alignr_epi8(msg1, msg0, 4));
+        msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+        /* rounds 24-27 */
+        msg = _mm_add_epi32(msg2, _mm_set_epi64x(0xbf597fc7b00327c8ULL, 0xa831c66d983e5152ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg3 = _mm_add_epi32(msg3, _mm_alignr_epi8(msg2, msg1, 4));
+        msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+        /* rounds 28-31 */
+        msg = _mm_add_epi32(msg3, _mm_set_epi64x(0x1429296706ca6351ULL, 0xd5a79147c6e00bf3ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg0 = _mm_add_epi32(msg0, _mm_alignr_epi8(msg3, msg2, 4));
+        msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+        /* rounds 32-35 */
+        msg = _mm_add_epi32(msg0, _mm_set_epi64x(0x53380d134d2c6dfcULL, 0x2e1b213827b70a85ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg1 = _mm_add_epi32(msg1, _mm_alignr_epi8(msg0, msg3, 4));
+        msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+        /* rounds 36-39 */
+        msg = _mm_add_epi32(msg1, _mm_set_epi64x(0x92722c8581c2c92eULL, 0x766a0abb650a7354ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg2 = _mm_add_epi32(msg2, _mm_alignr_epi8(msg1, msg0, 4));
+        msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg0 = _mm_sha256msg1_epu32(msg0, msg1);
+
+        /* rounds 40-43 */
+        msg = _mm_add_epi32(msg2, _mm_set_epi64x(0xc76c51a3c24b8b70ULL, 0xa81a664ba2bfe8a1ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg3 = _mm_add_epi32(msg3, _mm_alignr_epi8(msg2, msg1, 4));
+        msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg1 = _mm_sha256msg1_epu32(msg1, msg2);
+
+        /* rounds 44-47 */
+        msg = _mm_add_epi32(msg3, _mm_set_epi64x(0x106aa070f40e3585ULL, 0xd6990624d192e819ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg0 = _mm_add_epi32(msg0, _mm_alignr_epi8(msg3, msg2, 4));
+        msg0 = _mm_sha256msg2_epu32(msg0, msg3);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg2 = _mm_sha256msg1_epu32(msg2, msg3);
+
+        /* rounds 48-51 */
+        msg = _mm_add_epi32(msg0, _mm_set_epi64x(0x34b0bcb52748774cULL, 0x1e376c0819a4c116ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg1 = _mm_add_epi32(msg1, _mm_alignr_epi8(msg0, msg3, 4));
+        msg1 = _mm_sha256msg2_epu32(msg1, msg0);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+        msg3 = _mm_sha256msg1_epu32(msg3, msg0);
+
+        /* rounds 52-55 */
+        msg = _mm_add_epi32(msg1, _mm_set_epi64x(0x682e6ff35b9cca4fULL, 0x4ed8aa4a391c0cb3ULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg2 = _mm_add_epi32(msg2, _mm_alignr_epi8(msg1, msg0, 4));
+        msg2 = _mm_sha256msg2_epu32(msg2, msg1);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+        /* rounds 56-59 */
+        msg = _mm_add_epi32(msg2, _mm_set_epi64x(0x8cc7020884c87814ULL, 0x78a5636f748f82eeULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg3 = _mm_add_epi32(msg3, _mm_alignr_epi8(msg2, msg1, 4));
+        msg3 = _mm_sha256msg2_epu32(msg3, msg2);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+        /* rounds 60-63 */
+        msg = _mm_add_epi32(msg3, _mm_set_epi64x(0xc67178f2bef9a3f7ULL, 0xa4506ceb90befffaULL));
+        state1 = _mm_sha256rnds2_epu32(state1, state0, msg);
+        msg = _mm_shuffle_epi32(msg, 0x0E);
+        state0 = _mm_sha256rnds2_epu32(state0, state1, msg);
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    _mm_storeu_si128((__m128i *) &state[0], _mm_blend_epi16(tmp, state1, 0xF0));
+    _mm_storeu_si128((__m128i *) &state[4], _mm_alignr_epi8(state1, tmp, 8));
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#elif defined(__GNUC__)
+#pragma GCC pop_options
+#endif
+
+int sha_ni_available(void) {
+    const int need = CPU_X86_SHA | CPU_X86_SSSE3 | CPU_X86_SSE41;
+    return (cpu_x86_features() & need) == need;
+}
+
+#else
+
+int sha_ni_available(void) {
+    return 0;
+}
+
+#endif
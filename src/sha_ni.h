@@ -0,0 +1,42 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _SHA_NI_H
+#define _SHA_NI_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "cpu_features.h"
+
+/* non-zero if the CPU has the SHA extensions, in which case the functions
+   below may be used; they exist only when DIGEST_X86_SIMD is set */
+int sha_ni_available(void);
+
+#if DIGEST_X86_SIMD
+/* compress nblocks consecutive 64-byte blocks into the native-endian state */
+void sha1_process_blocks_shani(uint32_t state[5], const unsigned char *data, size_t nblocks);
+void sha256_process_blocks_shani(uint32_t state[8], const unsigned char *data, size_t nblocks);
+#endif
+
+#endif /* _SHA_NI_H */
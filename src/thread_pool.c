@@ -0,0 +1,231 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <stdlib.h>
+
+#include "thread_pool.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+typedef CRITICAL_SECTION pool_mutex;
+typedef CONDITION_VARIABLE pool_cond;
+typedef HANDLE pool_thread;
+#define pool_mutex_init(m)      InitializeCriticalSection(m)
+#define pool_mutex_destroy(m)   DeleteCriticalSection(m)
+#define pool_lock(m)            EnterCriticalSection(m)
+#define pool_unlock(m)          LeaveCriticalSection(m)
+#define pool_cond_init(c)       InitializeConditionVariable(c)
+#define pool_cond_destroy(c)    ((void) 0)
+#define pool_cond_wait(c, m)    SleepConditionVariableCS(c, m, INFINITE)
+#define pool_cond_signal(c)     WakeConditionVariable(c)
+#define pool_cond_broadcast(c)  WakeAllConditionVariable(c)
+#else
+#include <pthread.h>
+typedef pthread_mutex_t pool_mutex;
+typedef pthread_cond_t pool_cond;
+typedef pthread_t pool_thread;
+#define pool_mutex_init(m)      pthread_mutex_init(m, NULL)
+#define pool_mutex_destroy(m)   pthread_mutex_destroy(m)
+#define pool_lock(m)            pthread_mutex_lock(m)
+#define pool_unlock(m)          pthread_mutex_unlock(m)
+#define pool_cond_init(c)       pthread_cond_init(c, NULL)
+#define pool_cond_destroy(c)    pthread_cond_destroy(c)
+#define pool_cond_wait(c, m)    pthread_cond_wait(c, m)
+#define pool_cond_signal(c)     pthread_cond_signal(c)
+#define pool_cond_broadcast(c)  pthread_cond_broadcast(c)
+#endif
+
+struct thread_pool {
+    pool_mutex lock;
+    pool_cond work;             /* signalled when a task is queued or on shutdown */
+    pool_cond finished;         /* broadcast whenever a task completes */
+    pool_task *head, *tail;
+    int stop;
+    int nworkers;
+    pool_thread *workers;
+};
+
+/* called with the lock held */
+static pool_task *_pool_pop(thread_pool *pool) {
+    pool_task *task = pool->head;
+    if (task != NULL) {
+        pool->head = task->next;
+        if (pool->head == NULL) pool->tail = NULL;
+    }
+    return task;
+}
+
+/* called with the lock held, which is released while the task runs */
+static void _pool_run(thread_pool *pool, pool_task *task) {
+    pool_unlock(&pool->lock);
+    task->fn(task->arg);
+    pool_lock(&pool->lock);
+    task->done = 1;
+    pool_cond_broadcast(&pool->finished);
+}
+
+static void _pool_worker_loop(thread_pool *pool) {
+    pool_lock(&pool->lock);
+    for (;;) {
+        pool_task *task = _pool_pop(pool);
+        if (task != NULL) {
+            _pool_run(pool, task);
+        } else if (pool->stop) {
+            break;
+        } else {
+            pool_cond_wait(&pool->work, &pool->lock);
+        }
+    }
+    pool_unlock(&pool->lock);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI _pool_worker(LPVOID arg) {
+    _pool_worker_loop((thread_pool *) arg);
+    return 0;
+}
+#else
+static void *_pool_worker(void *arg) {
+    _pool_worker_loop((thread_pool *) arg);
+    return NULL;
+}
+#endif
+
+thread_pool *thread_pool_create(int nthreads) {
+    thread_pool *pool;
+
+    if (nthreads < 2) return NULL;
+    pool = (thread_pool *) calloc(1, sizeof(thread_pool));
+    if (pool == NULL) return NULL;
+    pool->workers = (pool_thread *) calloc(nthreads - 1, sizeof(pool_thread));
+    if (pool->workers == NULL) {
+        free(pool);
+        return NULL;
+    }
+    pool_mutex_init(&pool->lock);
+    pool_cond_init(&pool->work);
+    pool_cond_init(&pool->finished);
+
+    for (int i = 0; i < nthreads - 1; i++) {
+#ifdef _WIN32
+        pool->workers[i] = CreateThread(NULL, 0, _pool_worker, pool, 0, NULL);
+        if (pool->workers[i] == NULL) break;
+#else
+        if (pthread_create(&pool->workers[i], NULL, _pool_worker, pool) != 0) break;
+#endif
+        pool->nworkers++;
+    }
+    if (pool->nworkers == 0) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+void thread_pool_destroy(thread_pool *pool) {
+    if (pool == NULL) return;
+    pool_lock(&pool->lock);
+    pool->stop = 1;
+    pool_cond_broadcast(&pool->work);
+    pool_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->nworkers; i++) {
+#ifdef _WIN32
+        WaitForSingleObject(pool->workers[i], INFINITE);
+        CloseHandle(pool->workers[i]);
+#else
+        pthread_join(pool->workers[i], NULL);
+#endif
+    }
+    pool_cond_destroy(&pool->finished);
+    pool_cond_destroy(&pool->work);
+    pool_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+int thread_pool_size(const thread_pool *pool) {
+    return pool == NULL ? 1 : pool->nworkers + 1;
+}
+
+void thread_pool_submit(thread_pool *pool, pool_task *task) {
+    task->done = 0;
+    task->next = NULL;
+    pool_lock(&pool->lock);
+    if (pool->tail != NULL) pool->tail->next = task;
+    else pool->head = task;
+    pool->tail = task;
+    pool_cond_signal(&pool->work);
+    pool_unlock(&pool->lock);
+}
+
+void thread_pool_wait(thread_pool *pool, pool_task *task) {
+    pool_lock(&pool->lock);
+    while (!task->done) {
+        pool_task *other = _pool_pop(pool);
+        if (other != NULL) _pool_run(pool, other);
+        else pool_cond_wait(&pool->finished, &pool->lock);
+    }
+    pool_unlock(&pool->lock);
+}
+
+struct pool_gate {
+    pool_mutex lock;
+    pool_cond open;
+    int free;
+};
+
+pool_gate *pool_gate_create(int n) {
+    pool_gate *gate;
+
+    if (n < 1) return NULL;
+    gate = (pool_gate *) calloc(1, sizeof(pool_gate));
+    if (gate == NULL) return NULL;
+    pool_mutex_init(&gate->lock);
+    pool_cond_init(&gate->open);
+    gate->free = n;
+    return gate;
+}
+
+void pool_gate_destroy(pool_gate *gate) {
+    if (gate == NULL) return;
+    pool_cond_destroy(&gate->open);
+    pool_mutex_destroy(&gate->lock);
+    free(gate);
+}
+
+void pool_gate_enter(pool_gate *gate) {
+    if (gate == NULL) return;
+    pool_lock(&gate->lock);
+    while (gate->free == 0) pool_cond_wait(&gate->open, &gate->lock);
+    gate->free--;
+    pool_unlock(&gate->lock);
+}
+
+void pool_gate_leave(pool_gate *gate) {
+    if (gate == NULL) return;
+    pool_lock(&gate->lock);
+    gate->free++;
+    pool_cond_signal(&gate->open);
+    pool_unlock(&gate->lock);
+}
@@ -0,0 +1,67 @@
+/*
+
+  digest -- hash digest functions for R
+
+  Copyright (C) 2026 - current  Dirk Eddelbuettel <edd@debian.org>
+
+  This file is part of digest.
+
+  digest is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 2 of the License, or
+  (at your option) any later version.
+
+  digest is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with digest.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef _THREAD_POOL_H
+#define _THREAD_POOL_H
+
+/* A minimal fork-join pool on pthreads, or native threads on Windows.
+   Pools are created for the duration of a single call rather than kept
+   around, so that nothing is left running across fork() as done by
+   e.g. parallel::mclapply(). Tasks must not use the R API. */
+
+typedef struct pool_task {
+    void (*fn)(void *arg);
+    void *arg;
+    int done;                   /* guarded by the pool lock */
+    struct pool_task *next;
+} pool_task;
+
+typedef struct thread_pool thread_pool;
+
+/* starts nthreads - 1 workers, the calling thread being the last one;
+   returns NULL for nthreads < 2 or if no worker could be started, in
+   which case callers simply run serially */
+thread_pool *thread_pool_create(int nthreads);
+void thread_pool_destroy(thread_pool *pool);
+
+/* number of threads including the caller, i.e. 1 for a NULL pool */
+int thread_pool_size(const thread_pool *pool);
+
+/* queues a task, which must stay valid until thread_pool_wait() returns */
+void thread_pool_submit(thread_pool *pool, pool_task *task);
+
+/* waits for a task, running queued tasks meanwhile so that nested
+   submit/wait pairs (as in a recursive fork-join) cannot deadlock */
+void thread_pool_wait(thread_pool *pool, pool_task *task);
+
+/* A counting semaphore, e.g. to bound how many tasks of a pool do I/O at
+   the same time; returns NULL for n < 1 or if it cannot be allocated,
+   which enter and leave treat as no limit */
+typedef struct pool_gate pool_gate;
+
+pool_gate *pool_gate_create(int n);
+void pool_gate_destroy(pool_gate *gate);
+void pool_gate_enter(pool_gate *gate);
+void pool_gate_leave(pool_gate *gate);
+
+#endif /* _THREAD_POOL_H */